@@ -143,7 +143,7 @@ const PowerCC26XX_Config PowerCC26XX_config = {
 
 /* UART objects */
 UARTCC26XX_Object uartCC26XXObjects[CC2650STK_UARTCOUNT];
-unsigned char uartCC26XXRingBuffer[CC2650STK_UARTCOUNT][32];
+unsigned char uartCC26XXRingBuffer[CC2650STK_UARTCOUNT][128];
 
 /* UART hardware parameter structure, also used to assign UART pins */
 const UARTCC26XX_HWAttrsV2 uartCC26XXHWAttrs[CC2650STK_UARTCOUNT] = {
@@ -0,0 +1,77 @@
+/*
+ * boxcar.c
+ *
+ *  Running-sum moving average for 6-axis motion samples.
+ *
+ */
+
+#include <stdint.h>
+#include "boxcar.h"
+
+void boxcarInit(boxcar *filter, uint8_t len, uint8_t step) {
+    /*
+     * Initializes an empty filter
+     * @param uint8_t len is the window length, 1 to BOXCAR_MAX_LEN
+     * @param uint8_t step is the number of samples between outputs, 1 to len
+     */
+    if (len > BOXCAR_MAX_LEN) {
+        len = BOXCAR_MAX_LEN;
+    }
+    if (step == 0 || step > len) {
+        step = len;
+    }
+    filter->len = len;
+    filter->step = step;
+    boxcarReset(filter);
+}
+
+void boxcarReset(boxcar *filter) {
+    /*
+     * Empties the window, next output needs len new samples
+     */
+    uint8_t i = 0;
+    for (; i < BOXCAR_AXES; i++) {
+        filter->sum[i] = 0;
+    }
+    filter->index = 0;
+    filter->filled = 0;
+    filter->phase = 0;
+}
+
+uint8_t boxcarPut(boxcar *filter, const int16_t *sample, int16_t *avg) {
+    /*
+     * Adds a sample with one value per axis to the window
+     * @param int16_t *avg receives the window average per axis when output is due
+     * @return 1 if avg was written, 0 otherwise
+     */
+    uint8_t index = filter->index;
+    uint8_t i = 0;
+    if (filter->filled < filter->len) {
+        // Window not full yet, nothing to drop from the sum
+        for (; i < BOXCAR_AXES; i++) {
+            filter->sum[i] += sample[i];
+            filter->window[i][index] = sample[i];
+        }
+        filter->filled++;
+    } else {
+        for (; i < BOXCAR_AXES; i++) {
+            filter->sum[i] += sample[i] - filter->window[i][index];
+            filter->window[i][index] = sample[i];
+        }
+    }
+    index++;
+    if (index == filter->len) {
+        index = 0;
+    }
+    filter->index = index;
+
+    filter->phase++;
+    if (filter->filled < filter->len || filter->phase < filter->step) {
+        return 0;
+    }
+    filter->phase = 0;
+    for (i = 0; i < BOXCAR_AXES; i++) {
+        avg[i] = filter->sum[i] / filter->len;
+    }
+    return 1;
+}
@@ -0,0 +1,36 @@
+/*
+ * boxcar.h
+ *
+ *  Running-sum moving average for 6-axis motion samples.
+ *
+ *  The filter keeps the sum of the last len samples per axis, so each
+ *  new sample costs one add and one subtract per axis regardless of
+ *  the window length. An average is output every step samples:
+ *  step == len gives a tumbling (decimating) window, step == 1 a
+ *  sliding window at the full input rate.
+ *
+ */
+
+#ifndef BOXCAR_H_
+#define BOXCAR_H_
+
+#include <stdint.h>
+
+#define BOXCAR_AXES 6
+#define BOXCAR_MAX_LEN 8
+
+typedef struct boxcar {
+    int32_t sum[BOXCAR_AXES];
+    int16_t window[BOXCAR_AXES][BOXCAR_MAX_LEN];
+    uint8_t len;
+    uint8_t step;
+    uint8_t index;   // Oldest sample in window
+    uint8_t filled;  // Samples in window, up to len
+    uint8_t phase;   // Samples since the last output
+} boxcar;
+
+void boxcarInit(boxcar *filter, uint8_t len, uint8_t step);
+void boxcarReset(boxcar *filter);
+uint8_t boxcarPut(boxcar *filter, const int16_t *sample, int16_t *avg);
+
+#endif /* BOXCAR_H_ */
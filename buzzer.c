@@ -45,19 +45,32 @@
 // TI RTOS drivers
 #include <ti/drivers/Power.h>
 #include <ti/drivers/power/PowerCC26XX.h>
+#include <ti/sysbios/hal/Hwi.h>
 
 // Temporary PWM solution directly on DriverLib
 // (until a Timer RTOS driver is in place)
 #include <ti/drivers/pin/PINCC26XX.h>
 #include <driverlib/timer.h>
+#include <inc/hw_types.h>
+#include <inc/hw_gpt.h>
 
 #include "buzzer.h"
 
+/* -----------------------------------------------------------------------------
+*  Constants
+* ------------------------------------------------------------------------------
+*/
+// Timer ticks left in the period below which buzzerSetTone waits for the
+// timeout, so that its register writes can not straddle it. The writes take
+// a few cycles, the shortest period (BUZZER_FREQ_MAX) is 6000 ticks.
+#define LATCH_GUARD                64
+
 /* -----------------------------------------------------------------------------
 *  Local variables
 * ------------------------------------------------------------------------------
 */
 static PIN_Handle hPin = NULL;
+static bool running = false;
 
 /* -----------------------------------------------------------------------------
 *  Public Functions
@@ -78,14 +91,11 @@ void buzzerOpen(PIN_Handle hGpioPin)
     hPin = hGpioPin;
 
     // Turn on PERIPH power domain and clock for GPT0 and GPIO
+    // Standby is only disallowed while a tone is playing
     Power_setDependency(PowerCC26XX_PERIPH_GPT0);
-    Power_setConstraint(PowerCC26XX_SB_DISALLOW);
-
-    // Assign GPT0
-    TimerConfigure(GPT0_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PWM);
+    running = false;
 
-    // Configure pin for PWM output
-    PINCC26XX_setMux(hPin, Board_BUZZER, IOC_PORT_MCU_PORT_EVENT0);
+    // GPT0 is configured and the pin routed to it by the first buzzerSetTone
 }
 
 
@@ -98,41 +108,117 @@ void buzzerOpen(PIN_Handle hGpioPin)
  */
 bool buzzerSetFrequency(uint16_t freq)
 {
-    uint32_t ticks;
-    uint32_t loadLow;
-    uint32_t loadHigh;
-    uint32_t matchLow;
-    uint32_t matchHigh;
+    buzzerTone tone;
 
-    if (freq < BUZZER_FREQ_MIN && freq > BUZZER_FREQ_MAX)
+    if (!buzzerToneInit(&tone, freq))
     {
         return false;
     }
 
-    // Stop timer during reconfiguration
-    TimerDisable(GPT0_BASE, TIMER_A);
+    buzzerSetTone(&tone);
 
-    // Calculate timer load and match values
-    ticks = 48000000 / freq;
-    loadLow = ticks & 0x0000FFFF;
-    loadHigh = (ticks & 0x00FF0000) >> 16;
-    matchLow = (ticks / 2) & 0x0000FFFF;
-    matchHigh = ((ticks / 2) & 0x00FF0000) >> 16;
+    return true;
+}
 
-    // Set timer load
-    TimerLoadSet(GPT0_BASE, TIMER_A, loadLow);
-    TimerPrescaleSet(GPT0_BASE, TIMER_A, loadHigh);
+/*******************************************************************************
+ * @fn          buzzerToneInit
+ *
+ * @brief       Resolve the timer values of a frequency (3Hz - 8 KHz)
+ *
+ * @descr       For constant frequencies use BUZZER_TONE instead
+ *
+ * @return      return true if the frequency is within range
+ */
+bool buzzerToneInit(buzzerTone *tone, uint16_t freq)
+{
+    uint32_t ticks;
 
-    // Set timer match
-    TimerMatchSet(GPT0_BASE, TIMER_BOTH, matchLow);
-    TimerPrescaleMatchSet(GPT0_BASE, TIMER_A, matchHigh);
+    if (freq < BUZZER_FREQ_MIN || freq > BUZZER_FREQ_MAX)
+    {
+        return false;
+    }
 
-    // Start timer
-    TimerEnable(GPT0_BASE, TIMER_A);
+    ticks = BUZZER_PERIOD(freq);
+    tone->load = ticks & 0x0000FFFF;
+    tone->match = (ticks / 2) & 0x0000FFFF;
+    tone->loadHigh = (ticks & 0x00FF0000) >> 16;
+    tone->matchHigh = ((ticks / 2) & 0x00FF0000) >> 16;
 
     return true;
 }
 
+/*******************************************************************************
+ * @fn          buzzerSetTone
+ *
+ * @brief       Play a tone
+ *
+ * @descr       A running timer is not stopped, buzzerOpen sets the load
+ *              and match registers to update at the end of the current
+ *              period. The four writes are made with interrupts disabled
+ *              and not within LATCH_GUARD ticks of the timeout, so all of
+ *              them latch at the same timeout and no period mixes old
+ *              and new values. Interrupts are disabled for at most a few
+ *              microseconds.
+ *
+ * @return      -
+ */
+void buzzerSetTone(const buzzerTone *tone)
+{
+    if (!running)
+    {
+        // Timer registers are lost in standby, configure GPT0 again.
+        // Load and match updates take effect at the next timeout.
+        Power_setConstraint(PowerCC26XX_SB_DISALLOW);
+        TimerConfigure(GPT0_BASE, TIMER_CFG_SPLIT_PAIR | TIMER_CFG_A_PWM);
+        HWREG(GPT0_BASE + GPT_O_TAMR) |= GPT_TAMR_TAILD | GPT_TAMR_TAMRSU;
+    }
+
+    UInt key = Hwi_disable();
+    if (running)
+    {
+        // TAV counts down to the timeout, bits 23:16 are the prescaler
+        while ((HWREG(GPT0_BASE + GPT_O_TAV) & 0x00FFFFFF) < LATCH_GUARD)
+        {
+        }
+    }
+    HWREG(GPT0_BASE + GPT_O_TAPR) = tone->loadHigh;
+    HWREG(GPT0_BASE + GPT_O_TAILR) = tone->load;
+    HWREG(GPT0_BASE + GPT_O_TAPMR) = tone->matchHigh;
+    HWREG(GPT0_BASE + GPT_O_TAMATCHR) = tone->match;
+    Hwi_restore(key);
+
+    if (!running)
+    {
+        // Start from a full period and route the timer to the pin
+        HWREG(GPT0_BASE + GPT_O_TAV) = ((uint32_t)tone->loadHigh << 16) | tone->load;
+        TimerEnable(GPT0_BASE, TIMER_A);
+        PINCC26XX_setMux(hPin, Board_BUZZER, IOC_PORT_MCU_PORT_EVENT0);
+        running = true;
+    }
+}
+
+/*******************************************************************************
+ * @fn          buzzerSilence
+ *
+ * @brief       Silences the buzzer without closing the interface
+ *
+ * @descr       Stops the timer, drives the pin low and allows standby
+ *              during rests. The GPT0 dependency is kept so that the
+ *              next buzzerSetTone is cheap.
+ *
+ * @return      -
+ */
+void buzzerSilence(void)
+{
+    if (running)
+    {
+        TimerDisable(GPT0_BASE, TIMER_A);
+        PINCC26XX_setMux(hPin, Board_BUZZER, IOC_PORT_GPIO);
+        Power_releaseConstraint(PowerCC26XX_SB_DISALLOW);
+        running = false;
+    }
+}
+
 /*******************************************************************************
  * @fn          buzzerClose
  *
@@ -142,10 +228,9 @@ bool buzzerSetFrequency(uint16_t freq)
  */
 void buzzerClose(void)
 {
-    // Configure pin as GPIO
-    PINCC26XX_setMux(hPin, Board_BUZZER, IOC_PORT_GPIO);
+    // Stop timer and configure pin as GPIO
+    buzzerSilence();
 
     // Turn off PERIPH power domain and clock for GPT0
     Power_releaseDependency(PowerCC26XX_PERIPH_GPT0);
-    Power_releaseConstraint(PowerCC26XX_SB_DISALLOW);
 }
@@ -51,6 +51,30 @@
 */
 #define BUZZER_FREQ_MIN            3
 #define BUZZER_FREQ_MAX            8000
+#define BUZZER_CLOCK               48000000
+
+// Timer period of a frequency in 48 MHz ticks, 24 bits with the prescaler
+#define BUZZER_PERIOD(freq)        (BUZZER_CLOCK / (freq))
+
+// Tone descriptor for a constant frequency, resolved by the compiler
+#define BUZZER_TONE(freq)          {BUZZER_PERIOD(freq) & 0xFFFF, \
+                                    (BUZZER_PERIOD(freq) / 2) & 0xFFFF, \
+                                    (BUZZER_PERIOD(freq) >> 16) & 0xFF, \
+                                    (BUZZER_PERIOD(freq) / 2 >> 16) & 0xFF}
+#define BUZZER_REST                {0, 0, 0, 0}
+#define BUZZER_IS_REST(tone)       ((tone)->load == 0 && (tone)->loadHigh == 0)
+
+/* -----------------------------------------------------------------------------
+*                                          Typedefs
+* ------------------------------------------------------------------------------
+*/
+// Timer register values of a tone, 50 % duty cycle
+typedef struct buzzerTone {
+    uint16_t load;       // Interval load, low 16 bits of the period
+    uint16_t match;      // Match, low 16 bits of half the period
+    uint8_t loadHigh;    // Prescale, bits 23:16 of the period
+    uint8_t matchHigh;   // Prescale match, bits 23:16 of half the period
+} buzzerTone;
 
 /* -----------------------------------------------------------------------------
 *                                          Functions
@@ -58,6 +82,9 @@
 */
 void buzzerOpen(PIN_Handle hPinGpio);
 bool buzzerSetFrequency(uint16_t frequency);
+bool buzzerToneInit(buzzerTone *tone, uint16_t frequency);
+void buzzerSetTone(const buzzerTone *tone);
+void buzzerSilence(void);
 void buzzerClose(void);
 
 #endif
@@ -17,122 +17,148 @@
 #include "message.h"
 #include "coders.h"
 
-# define TABLE_LEN 36
-# define MAX_SYMBOL_LEN 5
+// Dichotomic (binary tree) decode table for morse symbols. The tree is stored
+// heap-ordered: the root is node 1, a dot moves to node 2n and a dash to node
+// 2n + 1. The leading 1-bit of a node index marks the symbol length, so every
+// symbol of up to MAX_SYMBOL_LEN elements has its own slot.
+static const char MORSE_TREE[MORSE_TREE_LEN] = {
+    '\0', '\0', 'E', 'T', 'I', 'A', 'N', 'M',
+    'S', 'U', 'R', 'W', 'D', 'K', 'G', 'O',
+    'H', 'V', 'F', '\0', 'L', '\0', 'P', 'J',
+    'B', 'X', 'C', 'Y', 'Z', 'Q', '\0', '\0',
+    '5', '4', '\0', '3', '\0', '\0', '\0', '2',
+    '&', '\0', '+', '\0', '\0', '\0', '\0', '1',
+    '6', '=', '/', '\0', '\0', '\0', '(', '\0',
+    '7', '\0', '\0', '\0', '8', '\0', '9', '0',
+    '\0', '\0', '\0', '\0', '\0', '\0', '\0', '\0',
+    '\0', '\0', '\0', '\0', '?', '_', '\0', '\0',
+    '\0', '\0', '"', '\0', '\0', '.', '\0', '\0',
+    '\0', '\0', '@', '\0', '\0', '\0', '\'', '\0',
+    '\0', '-', '\0', '\0', '\0', '\0', '\0', '\0',
+    '\0', '\0', ';', '!', '\0', ')', '\0', '\0',
+    '\0', '\0', '\0', ',', '\0', '\0', '\0', '\0',
+    ':', '\0', '\0', '\0', '\0', '\0', '\0', '\0'};
 
-const char ALPHABET[TABLE_LEN] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I',
-                         'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R',
-                         'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', '1',
-                         '2', '3', '4', '5', '6', '7', '8', '9', '0'};
+// ASCII to packed morse code. A packed code is the MORSE_TREE node of the
+// symbol, so its bits below the leading 1-bit are the elements (0 = '.',
+// 1 = '-') in sending order. Zero means the character has no morse code.
+# define MORSE_CHAR(c, code) [c] = code
+# define MORSE_LETTER(c, code) [c] = code, [(c) + 32] = code
 
-const char *MORSE_TABLE[TABLE_LEN] = {".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..",
-                             ".---", "-.-", ".-..", "--", "-.", "---", ".--.", "--.-", ".-.",
-                             "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--..", ".----",
-                             "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----.", "-----"};
+const uint8_t MORSE_CODES[ASCII_LEN] = {
+    MORSE_LETTER('A', 0x05), // .-
+    MORSE_LETTER('B', 0x18), // -...
+    MORSE_LETTER('C', 0x1A), // -.-.
+    MORSE_LETTER('D', 0x0C), // -..
+    MORSE_LETTER('E', 0x02), // .
+    MORSE_LETTER('F', 0x12), // ..-.
+    MORSE_LETTER('G', 0x0E), // --.
+    MORSE_LETTER('H', 0x10), // ....
+    MORSE_LETTER('I', 0x04), // ..
+    MORSE_LETTER('J', 0x17), // .---
+    MORSE_LETTER('K', 0x0D), // -.-
+    MORSE_LETTER('L', 0x14), // .-..
+    MORSE_LETTER('M', 0x07), // --
+    MORSE_LETTER('N', 0x06), // -.
+    MORSE_LETTER('O', 0x0F), // ---
+    MORSE_LETTER('P', 0x16), // .--.
+    MORSE_LETTER('Q', 0x1D), // --.-
+    MORSE_LETTER('R', 0x0A), // .-.
+    MORSE_LETTER('S', 0x08), // ...
+    MORSE_LETTER('T', 0x03), // -
+    MORSE_LETTER('U', 0x09), // ..-
+    MORSE_LETTER('V', 0x11), // ...-
+    MORSE_LETTER('W', 0x0B), // .--
+    MORSE_LETTER('X', 0x19), // -..-
+    MORSE_LETTER('Y', 0x1B), // -.--
+    MORSE_LETTER('Z', 0x1C), // --..
+    MORSE_CHAR('1', 0x2F), // .----
+    MORSE_CHAR('2', 0x27), // ..---
+    MORSE_CHAR('3', 0x23), // ...--
+    MORSE_CHAR('4', 0x21), // ....-
+    MORSE_CHAR('5', 0x20), // .....
+    MORSE_CHAR('6', 0x30), // -....
+    MORSE_CHAR('7', 0x38), // --...
+    MORSE_CHAR('8', 0x3C), // ---..
+    MORSE_CHAR('9', 0x3E), // ----.
+    MORSE_CHAR('0', 0x3F), // -----
+    MORSE_CHAR('.', 0x55), // .-.-.-
+    MORSE_CHAR(',', 0x73), // --..--
+    MORSE_CHAR('?', 0x4C), // ..--..
+    MORSE_CHAR('\'', 0x5E), // .----.
+    MORSE_CHAR('!', 0x6B), // -.-.--
+    MORSE_CHAR('/', 0x32), // -..-.
+    MORSE_CHAR('(', 0x36), // -.--.
+    MORSE_CHAR(')', 0x6D), // -.--.-
+    MORSE_CHAR('&', 0x28), // .-...
+    MORSE_CHAR(':', 0x78), // ---...
+    MORSE_CHAR(';', 0x6A), // -.-.-.
+    MORSE_CHAR('=', 0x31), // -...-
+    MORSE_CHAR('+', 0x2A), // .-.-.
+    MORSE_CHAR('-', 0x61), // -....-
+    MORSE_CHAR('_', 0x4D), // ..--.-
+    MORSE_CHAR('"', 0x52), // .-..-.
+    MORSE_CHAR('@', 0x5A)  // .--.-.
+};
 
-static uint8_t get_conversion_index(char *chr, uint8_t _idx) {
+void encode(char *chr, morseMsg *message, uint16_t len) {
     /*
-     * _idx is the index of '\0' character.
-     * Use _idx 0 for conversions from alphabet to morse
-     */
-    uint8_t i = 0;
-    if (_idx == 0) {
-        if ((64 < *chr && *chr < 91) || (96 < *chr && *chr < 123)) {
-            for (;i < TABLE_LEN - 10; i++) {
-                if (toupper(*chr) == ALPHABET[i]) {
-                    return i;
-                }
-            }
-        } else {
-            i = TABLE_LEN - 10;
-            for (;i < TABLE_LEN; i++) {
-                if (*chr == ALPHABET[i]) {
-                    return i;
-                }
-            }
-        }
-    } else {
-        for (;i < TABLE_LEN; i++) {
-            if (MORSE_TABLE[i][_idx] == '\0') {
-                uint8_t j = 0;
-                char *tmp = chr;
-                while (*tmp != '\0') {
-                    if (MORSE_TABLE[i][j] != *tmp) {
-                        break;
-                    } else if (j + 1 == _idx) {
-                        return i;
-                    }
-                    j++;
-                    tmp++;
-                }
-            }
-        }
-    }
-    return TABLE_LEN;
-}
-
-void encode(char *chr, msg* message, uint16_t len) {
-    /*
-     * Encoder from latin alphabet (including numbers 0-9) to morse code
+     * Encoder from latin alphabet, numbers 0-9 and punctuation to morse code
      * @param char *chr input string
-     * @param msg *message output destination as msg data struct
+     * @param morseMsg *message output destination as packed morse message
      * @param uint16_t len is length of input string
      */
-    uint8_t i = 0;
+    uint8_t code = 0;
     uint8_t j = 0;
     uint16_t k = 0;
     while(*chr != '\0' && k < len) {
         if (*chr == ' ') {
-            msgAppend(message, ' ');
+            morseMsgAppend(message, ' ');
         } else {
-            i = get_conversion_index(chr, 0);
-            if (i < TABLE_LEN) {
-                const char *code_char = MORSE_TABLE[i];
-                while (*code_char != '\0') {
-                    msgAppend(message, *code_char);
-                    code_char++;
-                }
-            } else {
+            code = 0;
+            if ((uint8_t)*chr < ASCII_LEN) {
+                code = MORSE_CODES[(uint8_t)*chr];
+            }
+            if (code == 0) {
                 // All unrecognized characters are encoded as '?'.
-                msgAppend(message, '?');
+                code = MORSE_CODES['?'];
             }
-            msgAppend(message, ' ');
+            morseMsgAppendSymbol(message, code);
         }
         chr++;
         k++;
     }
     j = 0;
     for (; j < 2; j++) {
-        msgAppend(message, ' ');
+        morseMsgAppend(message, ' ');
     }
 }
 
 
-void decode(char *chr, msg *message, uint16_t len) {
+void decode(const morseMsg *morse, msg *message) {
     /*
-     * Decoder from morse code to latin alphabet (including numbers 0-9)
-     * @param char *chr input string
+     * Decoder from morse code to latin alphabet, numbers 0-9 and punctuation
+     * Each element walks one node of MORSE_TREE, so no string compares are needed.
+     * @param morseMsg *morse input as packed morse message
      * @param msg *message output destination as msg data struct
-     * @param uint16_t len is length of input string
      */
-    char tmp[MAX_SYMBOL_LEN + 1];
+    uint8_t node = MORSE_TREE_ROOT;
+    uint8_t code = 0;
     uint8_t i = 0;
-    uint8_t j = 0;
     uint8_t space_count = 0;
     uint16_t k = 0;
 
-    while (*chr != '\0' && k < len) {
-        if (*chr == ' ') {
+    for (; k < morse->count; k++) {
+        code = morseMsgGetCode(morse, k);
+        if (code == MORSE_SPACE) {
             space_count++;
             if (space_count == 1 && i > 0) {
-                tmp[i] = '\0';
-                j = get_conversion_index(tmp, i);
-                if (j < TABLE_LEN) {
-                    msgAppend(message, ALPHABET[j]);
+                if (i <= MAX_SYMBOL_LEN && MORSE_TREE[node] != '\0') {
+                    msgAppend(message, MORSE_TREE[node]);
                 } else {
                     msgAppend(message, '?');
                 }
-                memset(tmp, '\0', i);
+                node = MORSE_TREE_ROOT;
                 i = 0;
             } if (space_count == 3) {
                 break;
@@ -142,10 +168,13 @@ void decode(char *chr, msg *message, uint16_t len) {
                 msgAppend(message, ' ');
             }
             space_count = 0;
-            tmp[i] = *chr;
-            i++;
+            if (i < MAX_SYMBOL_LEN) {
+                node = (node << 1) | (code == MORSE_DASH);
+            }
+            // Stop counting past the longest symbol so i cannot wrap
+            if (i <= MAX_SYMBOL_LEN) {
+                i++;
+            }
         }
-        chr++;
-        k++;
     }
 }
@@ -18,13 +18,14 @@
 #include <stdlib.h>
 #include "message.h"
 
-# define TABLE_LEN 36
-# define MAX_SYMBOL_LEN 5
+# define MAX_SYMBOL_LEN 6
+# define MORSE_TREE_ROOT 1
+# define MORSE_TREE_LEN (2 << MAX_SYMBOL_LEN)
+# define ASCII_LEN 128
 
-extern const char ALPHABET[TABLE_LEN];
-extern const char *MORSE_TABLE[TABLE_LEN];
+extern const uint8_t MORSE_CODES[ASCII_LEN];
 
-void encode(char *chr, msg* message, uint16_t len);
-void decode(char *chr, msg *message, uint16_t len);
+void encode(char *chr, morseMsg *message, uint16_t len);
+void decode(const morseMsg *morse, msg *message);
 
 #endif /* CODERS_H_ */
@@ -0,0 +1,89 @@
+/*
+ * cpumeter.c
+ *
+ *  Busy/idle time measurement for application tasks.
+ *
+ */
+
+#include <stdint.h>
+#include <xdc/std.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include "cpumeter.h"
+
+static uint32_t startTick = 0;
+static uint32_t beginTick[CPU_METER_TASKS];
+static uint32_t busyTicks[CPU_METER_TASKS];
+static uint8_t openSections = 0;
+static uint32_t unionBeginTick = 0;
+static uint32_t unionTicks = 0;
+
+void cpuMeterReset(void) {
+    /*
+     * Starts a new measurement window
+     */
+    uint8_t i = 0;
+    UInt key = Hwi_disable();
+    startTick = Clock_getTicks();
+    for (; i < CPU_METER_TASKS; i++) {
+        beginTick[i] = startTick;
+        busyTicks[i] = 0;
+    }
+    unionBeginTick = startTick;
+    unionTicks = 0;
+    Hwi_restore(key);
+}
+
+void cpuMeterBegin(uint8_t task) {
+    /*
+     * Marks the start of work for task
+     */
+    UInt key = Hwi_disable();
+    beginTick[task] = Clock_getTicks();
+    if (openSections++ == 0) {
+        unionBeginTick = beginTick[task];
+    }
+    Hwi_restore(key);
+}
+
+void cpuMeterEnd(uint8_t task) {
+    /*
+     * Adds the time since cpuMeterBegin to the busy time of task
+     */
+    UInt key = Hwi_disable();
+    uint32_t now = Clock_getTicks();
+    busyTicks[task] += now - beginTick[task];
+    if (--openSections == 0) {
+        unionTicks += now - unionBeginTick;
+    }
+    Hwi_restore(key);
+}
+
+uint32_t cpuMeterBusyTicks(uint8_t task) {
+    /*
+     * Busy time of task in clock ticks since cpuMeterReset
+     */
+    return busyTicks[task];
+}
+
+uint32_t cpuMeterUnionTicks(void) {
+    /*
+     * Time in clock ticks since cpuMeterReset when any task was busy,
+     * overlapping sections are counted once
+     */
+    uint32_t ticks;
+    UInt key = Hwi_disable();
+    ticks = unionTicks;
+    if (openSections > 0) {
+        ticks += Clock_getTicks() - unionBeginTick;
+    }
+    Hwi_restore(key);
+    return ticks;
+}
+
+uint32_t cpuMeterElapsedTicks(void) {
+    /*
+     * Clock ticks since cpuMeterReset
+     */
+    return Clock_getTicks() - startTick;
+}
@@ -0,0 +1,28 @@
+/*
+ * cpumeter.h
+ *
+ *  Busy/idle time measurement for application tasks.
+ *
+ *  Each task wraps the work it does after waking up with cpuMeterBegin
+ *  and cpuMeterEnd. A section is wall clock time, it includes time the
+ *  task is blocked in it (e.g. waiting for an I2C transfer) or preempted,
+ *  so the busy times of tasks can overlap. cpuMeterUnionTicks counts the
+ *  time when at least one section was open only once.
+ *
+ */
+
+#ifndef CPUMETER_H_
+#define CPUMETER_H_
+
+#include <stdint.h>
+
+#define CPU_METER_TASKS 4
+
+void cpuMeterReset(void);
+void cpuMeterBegin(uint8_t task);
+void cpuMeterEnd(uint8_t task);
+uint32_t cpuMeterBusyTicks(uint8_t task);
+uint32_t cpuMeterUnionTicks(void);
+uint32_t cpuMeterElapsedTicks(void);
+
+#endif /* CPUMETER_H_ */
@@ -0,0 +1,175 @@
+/*
+ * extflash.c
+ *
+ *  Minimal driver for the SensorTag's external SPI NOR flash.
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <xdc/std.h>
+#include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/drivers/PIN.h>
+#include <ti/drivers/SPI.h>
+
+#include "Board.h"
+#include "extflash.h"
+
+// JEDEC commands
+#define CMD_READ 0x03
+#define CMD_PAGE_PROGRAM 0x02
+#define CMD_SECTOR_ERASE 0x20
+#define CMD_WRITE_ENABLE 0x06
+#define CMD_READ_STATUS 0x05
+#define CMD_DEEP_POWER_DOWN 0xB9
+#define CMD_RELEASE_POWER_DOWN 0xAB
+#define CMD_JEDEC_ID 0x9F
+
+#define STATUS_BUSY 0x01
+#define BUSY_TIMEOUT 500 // Max time (ms) for an erase or program to finish
+
+static SPI_Handle spi = NULL;
+static PIN_Handle csHandle = NULL;
+static PIN_State csState;
+
+static PIN_Config csConfig[] = {
+    Board_SPI_FLASH_CS | PIN_GPIO_OUTPUT_EN | PIN_GPIO_HIGH | PIN_PUSHPULL | PIN_DRVSTR_MIN,
+    PIN_TERMINATE
+};
+
+static uint8_t transfer(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+    SPI_Transaction transaction;
+    transaction.count = len;
+    transaction.txBuf = (void *)tx;
+    transaction.rxBuf = rx;
+    return SPI_transfer(spi, &transaction);
+}
+
+static uint8_t command(const uint8_t *cmd, uint8_t cmdLen, const uint8_t *tx, uint8_t *rx, uint16_t len) {
+    /*
+     * Sends a command and optionally writes or reads data in the same chip select
+     */
+    uint8_t ok;
+    PIN_setOutputValue(csHandle, Board_SPI_FLASH_CS, Board_FLASH_CS_ON);
+    ok = transfer(cmd, NULL, cmdLen);
+    if (ok && len > 0) {
+        ok = transfer(tx, rx, len);
+    }
+    PIN_setOutputValue(csHandle, Board_SPI_FLASH_CS, Board_FLASH_CS_OFF);
+    return ok;
+}
+
+static uint8_t waitReady(void) {
+    uint8_t cmd = CMD_READ_STATUS;
+    uint8_t status;
+    uint16_t waited = 0;
+    do {
+        if (!command(&cmd, 1, NULL, &status, 1)) {
+            return 0;
+        }
+        if (!(status & STATUS_BUSY)) {
+            return 1;
+        }
+        Task_sleep(1000 / Clock_tickPeriod);
+        waited++;
+    } while (waited < BUSY_TIMEOUT);
+    return 0;
+}
+
+static uint8_t addressCommand(uint8_t *cmd, uint8_t op, uint32_t addr) {
+    cmd[0] = op;
+    cmd[1] = addr >> 16;
+    cmd[2] = addr >> 8;
+    cmd[3] = addr;
+    return 4;
+}
+
+uint8_t extFlashOpen(void) {
+    /*
+     * Opens SPI, wakes the flash from deep power-down and checks that it answers
+     * @return 1 on success
+     */
+    SPI_Params params;
+    uint8_t cmd = CMD_RELEASE_POWER_DOWN;
+    uint8_t id[3];
+
+    if (csHandle == NULL) {
+        csHandle = PIN_open(&csState, csConfig);
+        if (csHandle == NULL) {
+            return 0;
+        }
+    }
+    SPI_Params_init(&params);
+    params.bitRate = 4000000;
+    params.mode = SPI_MASTER;
+    params.transferMode = SPI_MODE_BLOCKING;
+    spi = SPI_open(Board_SPI0, &params);
+    if (spi == NULL) {
+        return 0;
+    }
+    command(&cmd, 1, NULL, NULL, 0);
+    Task_sleep(1000 / Clock_tickPeriod); // Wake up takes up to 35 us
+
+    cmd = CMD_JEDEC_ID;
+    if (!command(&cmd, 1, NULL, id, 3) || id[0] == 0x00 || id[0] == 0xFF) {
+        extFlashClose();
+        return 0;
+    }
+    return 1;
+}
+
+void extFlashClose(void) {
+    /*
+     * Puts the flash into deep power-down and closes SPI
+     */
+    uint8_t cmd = CMD_DEEP_POWER_DOWN;
+    if (spi == NULL) {
+        return;
+    }
+    command(&cmd, 1, NULL, NULL, 0);
+    SPI_close(spi);
+    spi = NULL;
+}
+
+uint8_t extFlashRead(uint32_t addr, uint8_t *data, uint16_t len) {
+    uint8_t cmd[4];
+    return command(cmd, addressCommand(cmd, CMD_READ, addr), NULL, data, len);
+}
+
+uint8_t extFlashErase(uint32_t addr) {
+    /*
+     * Erases the EXTFLASH_SECTOR_SIZE sector containing addr
+     */
+    uint8_t cmd[4];
+    uint8_t wren = CMD_WRITE_ENABLE;
+    if (!command(&wren, 1, NULL, NULL, 0) ||
+        !command(cmd, addressCommand(cmd, CMD_SECTOR_ERASE, addr), NULL, NULL, 0)) {
+        return 0;
+    }
+    return waitReady();
+}
+
+uint8_t extFlashWrite(uint32_t addr, const uint8_t *data, uint16_t len) {
+    /*
+     * Programs erased flash, split into page programs at page boundaries
+     */
+    uint8_t cmd[4];
+    uint8_t wren = CMD_WRITE_ENABLE;
+    while (len > 0) {
+        uint16_t chunk = EXTFLASH_PAGE_SIZE - (addr % EXTFLASH_PAGE_SIZE);
+        if (chunk > len) {
+            chunk = len;
+        }
+        if (!command(&wren, 1, NULL, NULL, 0) ||
+            !command(cmd, addressCommand(cmd, CMD_PAGE_PROGRAM, addr), data, NULL, chunk) ||
+            !waitReady()) {
+            return 0;
+        }
+        addr += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+    return 1;
+}
@@ -0,0 +1,26 @@
+/*
+ * extflash.h
+ *
+ *  Minimal driver for the SensorTag's external SPI NOR flash.
+ *
+ *  Uses only the common JEDEC commands, so it works with both the
+ *  Winbond and Macronix parts fitted on SensorTags. The flash is put
+ *  into deep power-down by extFlashClose and whenever it is not open.
+ *
+ */
+
+#ifndef EXTFLASH_H_
+#define EXTFLASH_H_
+
+#include <stdint.h>
+
+#define EXTFLASH_SECTOR_SIZE 4096
+#define EXTFLASH_PAGE_SIZE 256
+
+uint8_t extFlashOpen(void);
+void extFlashClose(void);
+uint8_t extFlashRead(uint32_t addr, uint8_t *data, uint16_t len);
+uint8_t extFlashErase(uint32_t addr);
+uint8_t extFlashWrite(uint32_t addr, const uint8_t *data, uint16_t len);
+
+#endif /* EXTFLASH_H_ */
@@ -0,0 +1,102 @@
+/*
+ * extrema.c
+ *
+ *  Sliding window maximum and minimum with monotonic deques.
+ *
+ */
+
+#include <stdint.h>
+#include "extrema.h"
+
+void extremaInit(extrema *ext, extremaEntry *storage, uint8_t window) {
+    /*
+     * Initializes empty max and min deques
+     * @param extremaEntry *storage is the deque memory, 2 * window entries
+     * @param uint8_t window is the number of slots in the caller's window
+     */
+    ext->window = window;
+    ext->max.data = storage;
+    ext->min.data = storage + window;
+    extremaReset(ext);
+}
+
+void extremaReset(extrema *ext) {
+    /*
+     * Forgets all values in the window
+     */
+    ext->max.head = 0;
+    ext->max.count = 0;
+    ext->min.head = 0;
+    ext->min.count = 0;
+}
+
+static void dropExpired(extremaDeque *deque, uint8_t slot, uint8_t window) {
+    /*
+     * Removes the front entry if its slot is being overwritten
+     */
+    if (deque->count > 0 && deque->data[deque->head].slot == slot) {
+        deque->head++;
+        if (deque->head == window) {
+            deque->head = 0;
+        }
+        deque->count--;
+    }
+}
+
+static void pushBack(extremaDeque *deque, int16_t value, uint8_t slot, uint8_t window) {
+    /*
+     * Adds an entry behind the last one, count is always below window here
+     */
+    uint8_t tail = deque->head + deque->count;
+    if (tail >= window) {
+        tail -= window;
+    }
+    deque->data[tail].value = value;
+    deque->data[tail].slot = slot;
+    deque->count++;
+}
+
+static uint8_t backIndex(const extremaDeque *deque, uint8_t window) {
+    uint8_t back = deque->head + deque->count - 1;
+    if (back >= window) {
+        back -= window;
+    }
+    return back;
+}
+
+void extremaPut(extrema *ext, int16_t value, uint8_t slot) {
+    /*
+     * Adds a value to the window, replacing the value that had the same slot
+     */
+    uint8_t window = ext->window;
+    dropExpired(&ext->max, slot, window);
+    dropExpired(&ext->min, slot, window);
+
+    // Smaller values before a new value can never be the max again
+    while (ext->max.count > 0 && ext->max.data[backIndex(&ext->max, window)].value < value) {
+        ext->max.count--;
+    }
+    pushBack(&ext->max, value, slot, window);
+
+    // Likewise larger values can never be the min again
+    while (ext->min.count > 0 && ext->min.data[backIndex(&ext->min, window)].value > value) {
+        ext->min.count--;
+    }
+    pushBack(&ext->min, value, slot, window);
+}
+
+int16_t extremaMax(const extrema *ext) {
+    return ext->max.data[ext->max.head].value;
+}
+
+int16_t extremaMin(const extrema *ext) {
+    return ext->min.data[ext->min.head].value;
+}
+
+uint8_t extremaMaxSlot(const extrema *ext) {
+    return ext->max.data[ext->max.head].slot;
+}
+
+uint8_t extremaMinSlot(const extrema *ext) {
+    return ext->min.data[ext->min.head].slot;
+}
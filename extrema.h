@@ -0,0 +1,44 @@
+/*
+ * extrema.h
+ *
+ *  Sliding window maximum and minimum with monotonic deques.
+ *
+ *  The caller keeps the window as a ring of slots 0..window-1 and
+ *  puts each new value with the slot it overwrites. A value leaves the
+ *  window when its slot is reused, so the max, the min and their slots
+ *  are available after every put in O(1) amortized time. Equal values
+ *  keep the oldest one, as a left to right scan would.
+ *
+ */
+
+#ifndef EXTREMA_H_
+#define EXTREMA_H_
+
+#include <stdint.h>
+
+typedef struct extremaEntry {
+    int16_t value;
+    uint8_t slot;
+} extremaEntry;
+
+typedef struct extremaDeque {
+    extremaEntry *data;
+    uint8_t head;
+    uint8_t count;
+} extremaDeque;
+
+typedef struct extrema {
+    extremaDeque max;  // Decreasing values, front is the max
+    extremaDeque min;  // Increasing values, front is the min
+    uint8_t window;
+} extrema;
+
+void extremaInit(extrema *ext, extremaEntry *storage, uint8_t window);
+void extremaReset(extrema *ext);
+void extremaPut(extrema *ext, int16_t value, uint8_t slot);
+int16_t extremaMax(const extrema *ext);
+int16_t extremaMin(const extrema *ext);
+uint8_t extremaMaxSlot(const extrema *ext);
+uint8_t extremaMinSlot(const extrema *ext);
+
+#endif /* EXTREMA_H_ */
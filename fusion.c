@@ -0,0 +1,163 @@
+/*
+ * fusion.c
+ *
+ *  Fixed-point Mahony orientation filter for accel and gyro samples.
+ *
+ */
+
+#include <stdint.h>
+#include "fusion.h"
+
+#define Q30_ONE (1L << 30)
+
+// Gyro counts into half of the rotation angle (Q30 rad) in one 5 ms sample, scaled by 64:
+// 0.5 * (pi / 180) / 131.072 LSB/dps * 0.005 s * 2^30 * 64 = 22877
+#define GYRO_HALF_DT_Q36 22877
+// Proportional gain Kp = 0.5 rad/s as a Q15 error into half angle (Q30) in one sample:
+// 0.5 * 0.5 * 0.005 s * 2^15 = 41
+#define KP_HALF_DT 41
+
+static int32_t mulQ30(int32_t a, int32_t b) {
+    return (int32_t)(((int64_t)a * b) >> 30);
+}
+
+static uint32_t isqrt(uint32_t x) {
+    /*
+     * Integer square root, floor(sqrt(x))
+     */
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= root + bit) {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+static int32_t atan2Bin(int32_t y, int32_t x) {
+    /*
+     * Binary angle of (x, y), 32768 = 180 degrees, max error about 0.25 degrees
+     * atan(z) = pi/4 z + 0.273 z (1 - z) for 0 <= z <= 1
+     */
+    uint32_t ay = y < 0 ? -(uint32_t)y : (uint32_t)y;
+    uint32_t ax = x < 0 ? -(uint32_t)x : (uint32_t)x;
+    int32_t angle;
+    if (ax == 0 && ay == 0) {
+        return 0;
+    }
+    uint8_t swap = ay > ax;
+    int32_t z = swap ? (int32_t)(((uint64_t)ax << 15) / ay) : (int32_t)(((uint64_t)ay << 15) / ax);
+    angle = ((8192 * z) >> 15) + ((2847 * ((z * (32768 - z)) >> 15)) >> 15);
+    if (swap) {
+        angle = 16384 - angle;
+    }
+    if (x < 0) {
+        angle = 32768 - angle;
+    }
+    if (y < 0) {
+        angle = -angle;
+    }
+    return angle > 32767 ? 32767 : angle;
+}
+
+void fusionReset(fusion *filter) {
+    filter->q[0] = Q30_ONE;
+    filter->q[1] = 0;
+    filter->q[2] = 0;
+    filter->q[3] = 0;
+    filter->started = 0;
+}
+
+static void startFromGravity(fusion *filter, int32_t ax, int32_t ay, int32_t az) {
+    /*
+     * Sets the orientation whose gravity direction is the measured one,
+     * normalized acceleration in Q15, yaw is zero
+     */
+    int32_t s = isqrt((uint32_t)(32768 + az) << 14);  // sqrt((1 + az) / 2) in Q15
+    filter->started = 1;
+    if (s < 1024) {
+        return; // Upside down, let the filter converge from identity
+    }
+    filter->q[0] = s << 15;
+    filter->q[1] = (int32_t)((int64_t)ay * (1L << 29) / s);
+    filter->q[2] = (int32_t)((int64_t)-ax * (1L << 29) / s);
+    filter->q[3] = 0;
+}
+
+void fusionUpdate(fusion *filter, const int16_t *sample) {
+    /*
+     * Integrates one sample of ax, ay, az, gx, gy, gz register counts
+     */
+    int32_t *q = filter->q;
+    int32_t q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    int32_t ax = sample[0], ay = sample[1], az = sample[2];
+    int32_t wx = (sample[3] * GYRO_HALF_DT_Q36) >> 6;
+    int32_t wy = (sample[4] * GYRO_HALF_DT_Q36) >> 6;
+    int32_t wz = (sample[5] * GYRO_HALF_DT_Q36) >> 6;
+
+    uint32_t norm = isqrt((uint32_t)(ax * ax) + (uint32_t)(ay * ay) + (uint32_t)(az * az));
+    if (norm != 0) {
+        // Measured gravity direction in Q15
+        ax = ax * 32768 / (int32_t)norm;
+        ay = ay * 32768 / (int32_t)norm;
+        az = az * 32768 / (int32_t)norm;
+        if (!filter->started) {
+            startFromGravity(filter, ax, ay, az);
+            return;
+        }
+        // Estimated gravity direction in Q15
+        int32_t vx = (mulQ30(q1, q3) - mulQ30(q0, q2)) >> 14;
+        int32_t vy = (mulQ30(q0, q1) + mulQ30(q2, q3)) >> 14;
+        int32_t vz = (mulQ30(q0, q0) - mulQ30(q1, q1) - mulQ30(q2, q2) + mulQ30(q3, q3)) >> 15;
+        // Error is the cross product of measured and estimated directions, Q15
+        int32_t ex = (ay * vz - az * vy) >> 15;
+        int32_t ey = (az * vx - ax * vz) >> 15;
+        int32_t ez = (ax * vy - ay * vx) >> 15;
+        wx += ex * KP_HALF_DT;
+        wy += ey * KP_HALF_DT;
+        wz += ez * KP_HALF_DT;
+    }
+
+    // q += q * (0, w), w is half the rotation of this sample
+    q[0] = q0 - mulQ30(q1, wx) - mulQ30(q2, wy) - mulQ30(q3, wz);
+    q[1] = q1 + mulQ30(q0, wx) + mulQ30(q2, wz) - mulQ30(q3, wy);
+    q[2] = q2 + mulQ30(q0, wy) - mulQ30(q1, wz) + mulQ30(q3, wx);
+    q[3] = q3 + mulQ30(q0, wz) + mulQ30(q1, wy) - mulQ30(q2, wx);
+
+    // Norm stays close to 1, so 1/sqrt(n) = (3 - n) / 2 is enough
+    int64_t n = ((int64_t)q[0] * q[0] + (int64_t)q[1] * q[1] +
+                 (int64_t)q[2] * q[2] + (int64_t)q[3] * q[3]) >> 30;
+    int32_t scale = (int32_t)((3 * (int64_t)Q30_ONE - n) >> 1);
+    q[0] = mulQ30(q[0], scale);
+    q[1] = mulQ30(q[1], scale);
+    q[2] = mulQ30(q[2], scale);
+    q[3] = mulQ30(q[3], scale);
+}
+
+void fusionAngles(const fusion *filter, int16_t *angles) {
+    /*
+     * Roll, pitch and yaw of the current orientation as binary angles
+     */
+    const int32_t *q = filter->q;
+    int32_t sinPitch = (mulQ30(q[0], q[2]) - mulQ30(q[3], q[1])) >> 14;  // Q15
+    if (sinPitch > 32767) {
+        sinPitch = 32767;
+    } else if (sinPitch < -32767) {
+        sinPitch = -32767;
+    }
+    int32_t cosPitch = isqrt((uint32_t)(Q30_ONE - sinPitch * sinPitch));
+
+    angles[FUSION_ROLL] = atan2Bin(mulQ30(q[0], q[1]) + mulQ30(q[2], q[3]),
+                                   (Q30_ONE >> 1) - mulQ30(q[1], q[1]) - mulQ30(q[2], q[2]));
+    angles[FUSION_PITCH] = atan2Bin(sinPitch, cosPitch);
+    angles[FUSION_YAW] = atan2Bin(mulQ30(q[0], q[3]) + mulQ30(q[1], q[2]),
+                                  (Q30_ONE >> 1) - mulQ30(q[2], q[2]) - mulQ30(q[3], q[3]));
+}
@@ -0,0 +1,63 @@
+/*
+ * gesture.c
+ *
+ *  Table-driven gesture recognition.
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "gesture.h"
+
+static uint8_t termHolds(const gestureTerm *term, const gestureWindow *window) {
+    switch (term->type) {
+    case GESTURE_MAX_ABOVE:
+        return window->max[term->axis] > term->threshold;
+    case GESTURE_MIN_BELOW:
+        return window->min[term->axis] < term->threshold;
+    case GESTURE_MAX_BELOW:
+        return window->max[term->axis] < term->threshold;
+    case GESTURE_MIN_ABOVE:
+        return window->min[term->axis] > term->threshold;
+    }
+    return 0;
+}
+
+static uint8_t orderHolds(const gestureDef *gesture, const gestureWindow *window) {
+    uint32_t maxTime = window->maxTime[gesture->orderAxis];
+    uint32_t minTime = window->minTime[gesture->orderAxis];
+    uint32_t span;
+    if (gesture->order == GESTURE_MAX_FIRST) {
+        if (maxTime >= minTime) {
+            return 0;
+        }
+        span = minTime - maxTime;
+    } else if (gesture->order == GESTURE_MIN_FIRST) {
+        if (minTime >= maxTime) {
+            return 0;
+        }
+        span = maxTime - minTime;
+    } else {
+        span = (maxTime > minTime) ? maxTime - minTime : minTime - maxTime;
+    }
+    return gesture->maxSpan == 0 || span <= gesture->maxSpan;
+}
+
+const gestureDef *gestureMatch(const gestureDef *table, uint8_t count, const gestureWindow *window) {
+    /*
+     * Finds the first gesture in table that matches the motion window
+     * @return matching gesture or NULL
+     */
+    uint8_t i = 0;
+    for (; i < count; i++) {
+        const gestureDef *gesture = &table[i];
+        uint8_t j = 0;
+        while (j < gesture->termCount && termHolds(&gesture->terms[j], window)) {
+            j++;
+        }
+        if (j == gesture->termCount && orderHolds(gesture, window)) {
+            return gesture;
+        }
+    }
+    return NULL;
+}
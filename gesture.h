@@ -0,0 +1,59 @@
+/*
+ * gesture.h
+ *
+ *  Table-driven gesture recognition.
+ *
+ *  Each gesture is a descriptor of up to GESTURE_MAX_TERMS threshold
+ *  terms on the max or min of an axis, optionally with the order and
+ *  time distance of the max and min of one axis. Gestures are checked
+ *  in table order against one summary of the motion window, so adding
+ *  a gesture adds only a few compares, not another pass over the data.
+ *  The module has no RTOS dependencies.
+ *
+ */
+
+#ifndef GESTURE_H_
+#define GESTURE_H_
+
+#include <stdint.h>
+
+#define GESTURE_AXES 8
+#define GESTURE_MAX_TERMS 4
+
+// Term types
+#define GESTURE_MAX_ABOVE 0 // max of axis > threshold
+#define GESTURE_MIN_BELOW 1 // min of axis < threshold
+#define GESTURE_MAX_BELOW 2 // max of axis < threshold
+#define GESTURE_MIN_ABOVE 3 // min of axis > threshold
+
+// Order of the max and min of orderAxis
+#define GESTURE_ANY_ORDER 0
+#define GESTURE_MAX_FIRST 1
+#define GESTURE_MIN_FIRST 2
+
+typedef struct gestureTerm {
+    uint8_t type;
+    uint8_t axis;
+    int16_t threshold;
+} gestureTerm;
+
+typedef struct gestureDef {
+    char symbol;        // Symbol sent when the gesture is recognized
+    uint8_t termCount;
+    gestureTerm terms[GESTURE_MAX_TERMS];
+    uint8_t orderAxis;
+    uint8_t order;
+    uint16_t maxSpan;   // Max time (ms) between max and min of orderAxis, 0 for no limit
+} gestureDef;
+
+// Summary of the motion window: ax, ay, az, gx, gy, gz, roll, pitch
+typedef struct gestureWindow {
+    int16_t max[GESTURE_AXES];
+    int16_t min[GESTURE_AXES];
+    uint32_t maxTime[GESTURE_AXES];
+    uint32_t minTime[GESTURE_AXES];
+} gestureWindow;
+
+const gestureDef *gestureMatch(const gestureDef *table, uint8_t count, const gestureWindow *window);
+
+#endif /* GESTURE_H_ */
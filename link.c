@@ -0,0 +1,104 @@
+/*
+ * link.c
+ *
+ *  Framed binary UART link protocol.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "link.h"
+
+// Parser states
+#define WAIT_START 0
+#define WAIT_LENGTH 1
+#define WAIT_TYPE 2
+#define WAIT_PAYLOAD 3
+#define WAIT_CRC 4
+
+uint8_t linkCrc8(uint8_t crc, uint8_t byte) {
+    /*
+     * Updates CRC-8 (polynomial 0x07) with one byte
+     */
+    uint8_t i = 0;
+    crc ^= byte;
+    for (; i < 8; i++) {
+        crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+    return crc;
+}
+
+uint8_t linkEncode(uint8_t type, const uint8_t *payload, uint8_t length, uint8_t *frame) {
+    /*
+     * Builds a frame
+     * @param uint8_t *frame output, must hold length + LINK_OVERHEAD bytes
+     * @return frame length in bytes or 0 if payload is too long
+     */
+    uint8_t crc = 0;
+    uint8_t i = 0;
+    if (length > LINK_MAX_PAYLOAD) {
+        return 0;
+    }
+    frame[0] = LINK_START;
+    frame[1] = length;
+    frame[2] = type;
+    crc = linkCrc8(crc, length);
+    crc = linkCrc8(crc, type);
+    for (; i < length; i++) {
+        frame[3 + i] = payload[i];
+        crc = linkCrc8(crc, payload[i]);
+    }
+    frame[3 + length] = crc;
+    return length + LINK_OVERHEAD;
+}
+
+void linkParserInit(linkParser *parser) {
+    /*
+     * Initializes parser to wait for a start byte
+     */
+    memset(parser, 0, sizeof(linkParser));
+    parser->state = WAIT_START;
+}
+
+uint8_t linkParse(linkParser *parser, uint8_t byte) {
+    /*
+     * Feeds one received byte to the parser
+     * On LINK_PARSE_DONE the frame is in parser.type, parser.length and parser.payload
+     * @return one of LINK_PARSE_IDLE, LINK_PARSE_BUSY, LINK_PARSE_DONE or LINK_PARSE_ERROR
+     */
+    switch (parser->state) {
+    case WAIT_START:
+        if (byte != LINK_START) {
+            return LINK_PARSE_IDLE;
+        }
+        parser->state = WAIT_LENGTH;
+        break;
+    case WAIT_LENGTH:
+        if (byte > LINK_MAX_PAYLOAD) {
+            parser->state = WAIT_START;
+            return LINK_PARSE_ERROR;
+        }
+        parser->length = byte;
+        parser->crc = linkCrc8(0, byte);
+        parser->state = WAIT_TYPE;
+        break;
+    case WAIT_TYPE:
+        parser->type = byte;
+        parser->crc = linkCrc8(parser->crc, byte);
+        parser->index = 0;
+        parser->state = (parser->length > 0) ? WAIT_PAYLOAD : WAIT_CRC;
+        break;
+    case WAIT_PAYLOAD:
+        parser->payload[parser->index] = byte;
+        parser->crc = linkCrc8(parser->crc, byte);
+        parser->index++;
+        if (parser->index == parser->length) {
+            parser->state = WAIT_CRC;
+        }
+        break;
+    case WAIT_CRC:
+        parser->state = WAIT_START;
+        return (byte == parser->crc) ? LINK_PARSE_DONE : LINK_PARSE_ERROR;
+    }
+    return LINK_PARSE_BUSY;
+}
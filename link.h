@@ -0,0 +1,66 @@
+/*
+ * link.h
+ *
+ *  Framed binary UART link protocol.
+ *
+ *  Frame: [LINK_START][length][type][payload, length bytes][crc]
+ *  crc is CRC-8 (polynomial 0x07) over length, type and payload.
+ *  The module has no RTOS dependencies so the same parser can be
+ *  built for the PC side of the link.
+ *
+ *  linkParse treats every LINK_START byte outside a frame as the start
+ *  of one. Text mode callers decide where a frame may start, see
+ *  receiveData in project_main.c.
+ *
+ */
+
+#ifndef LINK_H_
+#define LINK_H_
+
+#include <stdint.h>
+
+#define LINK_START 0x7E
+#define LINK_MAX_PAYLOAD 64
+#define LINK_OVERHEAD 4
+#define LINK_MAX_FRAME (LINK_MAX_PAYLOAD + LINK_OVERHEAD)
+
+// Frame types
+#define LINK_SYMBOLS 0x01   // Morse elements '.', '-' and ' ' as characters
+#define LINK_SAMPLES 0x02   // Sensor samples: uint32_t time (ms) and int16_t ax, ay, az, gx, gy, gz, little endian
+#define LINK_COMMAND 0x03   // Command id followed by its arguments
+
+// Commands, first byte of a LINK_COMMAND payload
+#define LINK_CMD_SET_BAUD 0x01  // uint32_t baud rate, little endian
+#define LINK_CMD_SET_MODE 0x02  // LINK_MODE_TEXT or LINK_MODE_BINARY
+#define LINK_CMD_RECORD 0x03    // 1 starts and 0 stops sending LINK_SAMPLES frames in binary mode
+#define LINK_CMD_CALIBRATE 0x04 // Reruns MPU9250 self test and calibration when not reading, keep the device still
+#define LINK_CMD_SET_WPM 0x05   // uint8_t wpm and uint8_t character wpm for Farnsworth spacing, 0 for standard
+#define LINK_CMD_LOW_POWER 0x06 // 1 closes UART after 2 s without traffic until the next received byte, 0 keeps it open
+#define LINK_CMD_ACK 0x80       // Id of the command that was carried out
+#define LINK_CMD_NAK 0x81       // Id of the command that was rejected, e.g. for a value out of range
+
+// Link modes
+#define LINK_MODE_TEXT 0
+#define LINK_MODE_BINARY 1
+
+// Results of linkParse
+#define LINK_PARSE_IDLE 0   // Byte is not part of a frame
+#define LINK_PARSE_BUSY 1   // Byte consumed, frame not complete yet
+#define LINK_PARSE_DONE 2   // Byte completed a valid frame
+#define LINK_PARSE_ERROR 3  // Frame dropped because of a bad length or crc
+
+typedef struct linkParser {
+    uint8_t state;
+    uint8_t length;
+    uint8_t type;
+    uint8_t index;
+    uint8_t crc;
+    uint8_t payload[LINK_MAX_PAYLOAD];
+} linkParser;
+
+uint8_t linkCrc8(uint8_t crc, uint8_t byte);
+uint8_t linkEncode(uint8_t type, const uint8_t *payload, uint8_t length, uint8_t *frame);
+void linkParserInit(linkParser *parser);
+uint8_t linkParse(linkParser *parser, uint8_t byte);
+
+#endif /* LINK_H_ */
@@ -13,54 +13,61 @@
 #include <string.h>
 #include <stdlib.h>
 #include <xdc/runtime/System.h>
+#include "message.h"
+#include "msgpool.h"
 
-# define DEFAULT_MSG_LEN 100
-# define MSG_MAX_SIZE 60000
+static const char MORSE_ELEMENTS[] = ".- ";
 
-typedef struct msg {
-    uint16_t count;
-    uint16_t size;
-    char *data;
-} msg;
+// 32-bit FNV-1a
+#define HASH_OFFSET 2166136261UL
+#define HASH_PRIME 16777619UL
+
+static inline void morseMsgPut(morseMsg *message, uint8_t code) {
+    /*
+     * Writes a 2-bit element code after the last element, capacity must be checked by caller
+     */
+    uint16_t byte = message->count / MORSE_ELEMENTS_PER_BYTE;
+    uint8_t shift = (message->count % MORSE_ELEMENTS_PER_BYTE) * 2;
+    message->data[byte] = (message->data[byte] & ~(0x03 << shift)) | (code << shift);
+    message->count++;
+}
 
 void msgInit(msg *message) {
     /*
      * Initializes message
      */
     message->count = 0;
-    message->size = DEFAULT_MSG_LEN;
-    message->data = malloc(message->size * sizeof(char));
+    message->data = msgPoolAcquire(DEFAULT_MSG_LEN, &message->size);
     if (message->data == NULL) {
         System_abort("Error: Message initialization failed!");
     }
-    memset(message->data, '\0', message->size);
+    message->data[0] = '\0';
 }
 
-static void msgRealloc(msg *message) {
+static uint8_t msgRealloc(msg *message) {
     /*
-     * Grows message.data size by DEFAULT_MSG_LEN
+     * Moves message.data into a pool slot at least twice as large
+     * Doubling keeps appends amortized O(1)
+     * @return 1 on success, 0 if no larger slot was free and message is unchanged
      */
-    if (message->size + DEFAULT_MSG_LEN > MSG_MAX_SIZE) {
-        free(message->data);
-        message->data = NULL;
-        System_abort("Error: message maximum size exeeced!");
-    }
-    message->size += DEFAULT_MSG_LEN;
-    char *tmp = realloc(message->data, message->size * sizeof(char));
+    uint16_t size = 0;
+    char *tmp = msgPoolAcquire(message->size * 2, &size);
     if (tmp == NULL) {
-        free(message->data);
-        message->data = NULL;
-        System_abort("Error: Ran out of memory for resizing message!");
+        return 0;
     }
+    memcpy(tmp, message->data, message->count);
+    msgPoolRelease(message->data);
     message->data = tmp;
+    message->size = size;
     tmp = NULL;
+    return 1;
 }
 
 void msgDestroy(msg *message) {
     /*
-     * Free memory used
+     * Return memory used to the pool
      */
-    free(message->data);
+    msgPoolRelease(message->data);
     message->data = NULL;
     message->count = 0;
     message->size = 0;
@@ -69,22 +76,253 @@ void msgDestroy(msg *message) {
 void msgClear(msg *message) {
     /*
      * Clear any data in message.data
+     * Only the count is reset, old data is overwritten by later appends
      */
     message->count = 0;
-    memset(message->data, '\0', message->size);
+    message->data[0] = '\0';
 }
 
-void msgAppend(msg *message, const char chr) {
+uint8_t msgAppend(msg *message, const char chr) {
     /*
      * Append a character at the message.data
-     * Null character is added in the end automatically
+     * Null character is not added, use msgString to read data as a string
+     * @return 1 on success, 0 if the pool ran out and chr was dropped
      */
-    if (chr != '\0') {
-        message->data[message->count] = chr;
-        message->count++;
+    if (chr == '\0') {
+        return 1;
+    }
+    if (message->count + 1 >= message->size && !msgRealloc(message)) {
+        return 0;
     }
-    if (message->count >= message->size) {
-        msgRealloc(message);
+    message->data[message->count] = chr;
+    message->count++;
+    return 1;
+}
+
+uint8_t msgAppendN(msg *message, const char *str, uint16_t len) {
+    /*
+     * Append len characters from str at the message.data
+     * @return 1 on success, 0 if the pool ran out and str was truncated
+     */
+    uint8_t ok = 1;
+    while ((uint32_t)message->count + len >= message->size) {
+        if (!msgRealloc(message)) {
+            len = message->size - 1 - message->count;
+            ok = 0;
+        }
     }
+    memcpy(message->data + message->count, str, len);
+    message->count += len;
+    return ok;
+}
+
+uint8_t msgAppendStr(msg *message, const char *str) {
+    /*
+     * Append a null terminated string at the message.data
+     * @return 1 on success, 0 if the pool ran out and str was truncated
+     */
+    return msgAppendN(message, str, strlen(str));
+}
+
+char *msgString(msg *message) {
+    /*
+     * Adds the null character after the data and returns it as a string
+     */
     message->data[message->count] = '\0';
+    return message->data;
+}
+
+void morseMsgInit(morseMsg *message) {
+    /*
+     * Initializes packed morse message
+     */
+    message->count = 0;
+    message->data = msgPoolAcquire(DEFAULT_MSG_LEN, &message->size);
+    if (message->data == NULL) {
+        System_abort("Error: Morse message initialization failed!");
+    }
+}
+
+static uint8_t morseMsgRealloc(morseMsg *message) {
+    /*
+     * Moves message.data into a pool slot at least twice as large
+     * @return 1 on success, 0 if no larger slot was free and message is unchanged
+     */
+    uint16_t size = 0;
+    uint8_t *tmp = msgPoolAcquire(message->size * 2, &size);
+    if (tmp == NULL) {
+        return 0;
+    }
+    memcpy(tmp, message->data, (message->count + MORSE_ELEMENTS_PER_BYTE - 1) / MORSE_ELEMENTS_PER_BYTE);
+    msgPoolRelease(message->data);
+    message->data = tmp;
+    message->size = size;
+    tmp = NULL;
+    return 1;
+}
+
+void morseMsgDestroy(morseMsg *message) {
+    /*
+     * Return memory used to the pool
+     */
+    msgPoolRelease(message->data);
+    message->data = NULL;
+    message->count = 0;
+    message->size = 0;
+}
+
+void morseMsgClear(morseMsg *message) {
+    /*
+     * Clear any elements in message.data
+     * Only the count is reset, appends overwrite the old element bits
+     */
+    message->count = 0;
+}
+
+uint8_t morseMsgAppend(morseMsg *message, const char chr) {
+    /*
+     * Append a morse element ('.', '-' or ' ') at the message.data
+     * Any other character is ignored
+     * @return 1 on success, 0 if the pool ran out and chr was dropped
+     */
+    uint8_t code;
+    if (chr == '.') {
+        code = MORSE_DOT;
+    } else if (chr == '-') {
+        code = MORSE_DASH;
+    } else if (chr == ' ') {
+        code = MORSE_SPACE;
+    } else {
+        return 1;
+    }
+    if ((uint32_t)message->count >= (uint32_t)message->size * MORSE_ELEMENTS_PER_BYTE &&
+        !morseMsgRealloc(message)) {
+        return 0;
+    }
+    morseMsgPut(message, code);
+    return 1;
+}
+
+uint8_t morseMsgAppendSymbol(morseMsg *message, uint8_t symbol) {
+    /*
+     * Append all elements of a packed symbol and the space after it
+     * @param uint8_t symbol is a packed code where the bits after the
+     *        leading 1-bit are the elements (0 = '.', 1 = '-') in order
+     * @return 1 on success, 0 if the pool ran out and the whole symbol was dropped
+     */
+    uint8_t bit = 0x80;
+    uint8_t len = 7;
+    if (symbol == 0) {
+        return 1;
+    }
+    while ((symbol & bit) == 0) {
+        bit >>= 1;
+        len--;
+    }
+    while ((uint32_t)message->count + len + 1 > (uint32_t)message->size * MORSE_ELEMENTS_PER_BYTE) {
+        if (!morseMsgRealloc(message)) {
+            return 0;
+        }
+    }
+    bit >>= 1;
+    while (bit != 0) {
+        morseMsgPut(message, (symbol & bit) ? MORSE_DASH : MORSE_DOT);
+        bit >>= 1;
+    }
+    morseMsgPut(message, MORSE_SPACE);
+    return 1;
+}
+
+uint8_t morseMsgGetCode(const morseMsg *message, uint16_t index) {
+    /*
+     * Returns the 2-bit element code (MORSE_DOT, MORSE_DASH or MORSE_SPACE) at index
+     */
+    uint8_t shift = (index % MORSE_ELEMENTS_PER_BYTE) * 2;
+    return (message->data[index / MORSE_ELEMENTS_PER_BYTE] >> shift) & 0x03;
+}
+
+char morseMsgGet(const morseMsg *message, uint16_t index) {
+    /*
+     * Returns the element at index as a character '.', '-' or ' '
+     */
+    return MORSE_ELEMENTS[morseMsgGetCode(message, index)];
+}
+
+uint8_t morseMsgUnpack(const morseMsg *message, msg *dest) {
+    /*
+     * Append all elements of message as characters at the end of dest
+     * @return 1 on success, 0 if the pool ran out and the elements were truncated
+     */
+    uint16_t i = 0;
+    uint16_t count = message->count;
+    uint8_t ok = 1;
+    while ((uint32_t)dest->count + count >= dest->size) {
+        if (!msgRealloc(dest)) {
+            count = dest->size - 1 - dest->count;
+            ok = 0;
+        }
+    }
+    for (; i < count; i++) {
+        dest->data[dest->count] = morseMsgGet(message, i);
+        dest->count++;
+    }
+    return ok;
+}
+
+static uint32_t morseHashEnd(uint32_t hash, uint16_t count) {
+    /*
+     * Mixes the element count into hash so that trailing dots change it
+     */
+    hash = (hash ^ (count & 0xFF)) * HASH_PRIME;
+    return (hash ^ (count >> 8)) * HASH_PRIME;
+}
+
+uint32_t morseMsgHash(const morseMsg *message) {
+    /*
+     * FNV-1a hash of the packed elements and the count, unused bits of the last byte are masked
+     * Equal to morseStrHash of the same elements as characters
+     */
+    uint32_t hash = HASH_OFFSET;
+    uint16_t full = message->count / MORSE_ELEMENTS_PER_BYTE;
+    uint8_t rest = message->count % MORSE_ELEMENTS_PER_BYTE;
+    uint16_t i = 0;
+    for (; i < full; i++) {
+        hash = (hash ^ message->data[i]) * HASH_PRIME;
+    }
+    if (rest > 0) {
+        hash = (hash ^ (message->data[full] & ((1 << (rest * 2)) - 1))) * HASH_PRIME;
+    }
+    return morseHashEnd(hash, message->count);
+}
+
+uint32_t morseStrHash(const char *str) {
+    /*
+     * Hash of a string of morse characters as if appended to an empty morseMsg
+     * Characters other than '.', '-' and ' ' are ignored like in morseMsgAppend
+     */
+    uint32_t hash = HASH_OFFSET;
+    uint16_t count = 0;
+    uint8_t byte = 0;
+    for (; *str != '\0'; str++) {
+        uint8_t code;
+        if (*str == '.') {
+            code = MORSE_DOT;
+        } else if (*str == '-') {
+            code = MORSE_DASH;
+        } else if (*str == ' ') {
+            code = MORSE_SPACE;
+        } else {
+            continue;
+        }
+        byte |= code << ((count % MORSE_ELEMENTS_PER_BYTE) * 2);
+        count++;
+        if (count % MORSE_ELEMENTS_PER_BYTE == 0) {
+            hash = (hash ^ byte) * HASH_PRIME;
+            byte = 0;
+        }
+    }
+    if (count % MORSE_ELEMENTS_PER_BYTE != 0) {
+        hash = (hash ^ byte) * HASH_PRIME;
+    }
+    return morseHashEnd(hash, count);
 }
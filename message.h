@@ -17,8 +17,14 @@
 #include <stdlib.h>
 #include <xdc/runtime/System.h>
 
+// Initial size, messages double in pool slots up to MSG_POOL_MAX_SLOT_SIZE bytes
 #define DEFAULT_MSG_LEN 100
-#define MSG_MAX_SIZE 60000
+
+// 2-bit morse element codes used by morseMsg
+#define MORSE_DOT 0
+#define MORSE_DASH 1
+#define MORSE_SPACE 2
+#define MORSE_ELEMENTS_PER_BYTE 4
 
 typedef struct msg {
     uint16_t count;
@@ -26,9 +32,30 @@ typedef struct msg {
     char *data;
 } msg;
 
+// Morse message packed 2 bits per element. size is in bytes, count in elements.
+typedef struct morseMsg {
+    uint16_t count;
+    uint16_t size;
+    uint8_t *data;
+} morseMsg;
+
 void msgInit(msg *message);
 void msgDestroy(msg *message);
 void msgClear(msg *message);
-void msgAppend(msg *message, const char chr);
+uint8_t msgAppend(msg *message, const char chr);
+uint8_t msgAppendN(msg *message, const char *str, uint16_t len);
+uint8_t msgAppendStr(msg *message, const char *str);
+char *msgString(msg *message);
+
+void morseMsgInit(morseMsg *message);
+void morseMsgDestroy(morseMsg *message);
+void morseMsgClear(morseMsg *message);
+uint8_t morseMsgAppend(morseMsg *message, const char chr);
+uint8_t morseMsgAppendSymbol(morseMsg *message, uint8_t symbol);
+uint8_t morseMsgGetCode(const morseMsg *message, uint16_t index);
+char morseMsgGet(const morseMsg *message, uint16_t index);
+uint8_t morseMsgUnpack(const morseMsg *message, msg *dest);
+uint32_t morseMsgHash(const morseMsg *message);
+uint32_t morseStrHash(const char *str);
 
 #endif /* MESSAGE_H_ */
@@ -0,0 +1,44 @@
+/*
+ * morsetime.c
+ *
+ *  Morse element timing from words per minute.
+ *
+ */
+
+#include <stdint.h>
+#include "morsetime.h"
+
+#define PARIS_UNIT_MS 1200 // One unit at 1 wpm, PARIS is 50 units long
+
+uint8_t morseTimingSet(morseTiming *timing, uint8_t wpm, uint8_t charWpm) {
+    /*
+     * Computes the durations for a speed
+     * @param wpm: overall words per minute
+     * @param charWpm: element speed for Farnsworth spacing, 0 or wpm for standard spacing
+     * @return 1 if the speeds are within MORSE_WPM_MIN - MORSE_WPM_MAX, otherwise timing is not changed
+     */
+    if (charWpm == 0) {
+        charWpm = wpm;
+    }
+    if (wpm < MORSE_WPM_MIN || charWpm > MORSE_WPM_MAX || charWpm < wpm) {
+        return 0;
+    }
+    uint16_t unit = PARIS_UNIT_MS / charWpm;
+    timing->wpm = wpm;
+    timing->charWpm = charWpm;
+    timing->dot = unit;
+    timing->dash = 3 * unit;
+    timing->elementGap = unit;
+    if (charWpm > wpm) {
+        // Farnsworth: the 19 units of letter and word gaps in PARIS take
+        // the time left over from the 31 units of elements at charWpm
+        uint32_t delay = (60000UL * charWpm - 37200UL * wpm) / ((uint32_t)wpm * charWpm);
+        timing->letterGap = 3 * delay / 19;
+        timing->wordGap = 7 * delay / 19;
+    } else {
+        timing->letterGap = 3 * unit;
+        timing->wordGap = 7 * unit;
+    }
+    timing->messageGap = timing->wordGap + timing->letterGap;
+    return 1;
+}
@@ -0,0 +1,35 @@
+/*
+ * morsetime.h
+ *
+ *  Morse element timing from words per minute.
+ *
+ *  Durations follow the PARIS standard: a dot is one unit of 1200 / wpm
+ *  ms, a dash three units, the gap between elements one unit, between
+ *  letters three and between words seven units. With Farnsworth spacing
+ *  elements are sent at charWpm and only the letter and word gaps are
+ *  stretched so that the overall speed is wpm.
+ *
+ */
+
+#ifndef MORSETIME_H_
+#define MORSETIME_H_
+
+#include <stdint.h>
+
+#define MORSE_WPM_MIN 5
+#define MORSE_WPM_MAX 60
+
+typedef struct morseTiming {
+    uint8_t wpm;         // Overall speed
+    uint8_t charWpm;     // Speed of the elements within a letter, >= wpm
+    uint16_t dot;        // Durations in milliseconds
+    uint16_t dash;
+    uint16_t elementGap; // Between elements of a letter
+    uint16_t letterGap;  // Between letters, including the element gap
+    uint16_t wordGap;    // Between words, including the letter gap
+    uint16_t messageGap; // Silence that ends a received message
+} morseTiming;
+
+uint8_t morseTimingSet(morseTiming *timing, uint8_t wpm, uint8_t charWpm);
+
+#endif /* MORSETIME_H_ */
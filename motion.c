@@ -0,0 +1,135 @@
+/*
+ * motion.c
+ *
+ *  Motion pipeline from MPU9250 samples to morse symbols.
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "motion.h"
+#include "boxcar.h"
+#include "extrema.h"
+#include "gesture.h"
+#include "fusion.h"
+
+// Gesture thresholds as register counts, scaled at compile time
+#define TURN_ANGLE MOTION_ANGLE_DEG(45) // Roll a turn reaches
+#define TURN_LEVEL MOTION_ANGLE_DEG(15) // Max roll where a turn starts
+#define TURN_PITCH MOTION_ANGLE_DEG(30) // Max pitch during a turn either way
+#define SHAKE_GYRO MOTION_GYRO_DPS(200) // Angular rate of a shake around z in both directions
+#define SHAKE_SPAN 150 // Max time (ms) between the swings of a shake
+
+// Recognized moves in priority order
+// Axes: 0 ax, 1 ay, 2 az, 3 gx, 4 gy, 5 gz, 6 roll, 7 pitch (MOTION_ANGLE_DEG)
+// Turns are judged on the fused roll instead of peak rates, any turn that
+// gets past TURN_ANGLE within MOTION_WINDOW counts and vibration that
+// does not tilt the device is filtered out
+static const gestureDef GESTURES[] = {
+    // Turn to left, roll rises from level past TURN_ANGLE
+    {'.', 4, {{GESTURE_MIN_BELOW, 6, TURN_LEVEL},
+              {GESTURE_MAX_ABOVE, 6, TURN_ANGLE},
+              {GESTURE_MAX_BELOW, 7, TURN_PITCH},
+              {GESTURE_MIN_ABOVE, 7, -TURN_PITCH}}, 6, GESTURE_MIN_FIRST, 0},
+    // Turn to right, roll falls from level past -TURN_ANGLE
+    {'-', 4, {{GESTURE_MAX_ABOVE, 6, -TURN_LEVEL},
+              {GESTURE_MIN_BELOW, 6, -TURN_ANGLE},
+              {GESTURE_MAX_BELOW, 7, TURN_PITCH},
+              {GESTURE_MIN_ABOVE, 7, -TURN_PITCH}}, 6, GESTURE_MAX_FIRST, 0},
+    // Quick shake around z, same as button 1
+    {' ', 2, {{GESTURE_MAX_ABOVE, 5, SHAKE_GYRO},
+              {GESTURE_MIN_BELOW, 5, -SHAKE_GYRO}}, 5, GESTURE_ANY_ORDER, SHAKE_SPAN}
+};
+#define GESTURE_COUNT (sizeof(GESTURES) / sizeof(gestureDef))
+
+// Motion data is kept as int16 register counts, the Cortex-M3 has no FPU
+static boxcar avgFilter;
+static fusion orientation;
+// Max and min of the last NUM_SAMPLES averages per axis and angles
+// Slot of a sample is its index in times
+static extremaEntry extremaStorage[MOTION_TRACKED][2 * NUM_SAMPLES];
+static extrema motionExtrema[MOTION_TRACKED];
+static uint32_t times[NUM_SAMPLES];
+static gestureWindow motionWindow;
+static uint8_t dataIndex = 0;
+static uint8_t dataReadyNum = 0;
+
+void motionInit(void) {
+    boxcarInit(&avgFilter, AVG_WIN_SIZE, AVG_STEP);
+    uint8_t axis = 0;
+    for (; axis < MOTION_TRACKED; axis++) {
+        extremaInit(&motionExtrema[axis], extremaStorage[axis], NUM_SAMPLES);
+    }
+    motionReset();
+}
+
+void motionReset(void) {
+    /*
+     * Forgets all motion data, called when a reading session starts
+     */
+    boxcarReset(&avgFilter);
+    fusionReset(&orientation);
+    uint8_t axis = 0;
+    for (; axis < MOTION_TRACKED; axis++) {
+        extremaReset(&motionExtrema[axis]);
+    }
+    dataReadyNum = 0;
+}
+
+static void getMaxMin(void) {
+    // Extrema are tracked as samples arrive, only read them out here
+    uint8_t i = 0;
+    for (; i < MOTION_TRACKED; i++) {
+        motionWindow.max[i] = extremaMax(&motionExtrema[i]);
+        motionWindow.min[i] = extremaMin(&motionExtrema[i]);
+        motionWindow.maxTime[i] = times[extremaMaxSlot(&motionExtrema[i])];
+        motionWindow.minTime[i] = times[extremaMinSlot(&motionExtrema[i])];
+    }
+}
+
+static char checkMoves(void) {
+    getMaxMin();
+    const gestureDef *move = gestureMatch(GESTURES, GESTURE_COUNT, &motionWindow);
+    if (move != NULL) {
+        return move->symbol;
+    }
+    return 0;
+}
+
+char motionPut(const int16_t *sample, uint32_t time) {
+    /*
+     * Moves a sample forward in the motion pipeline
+     * The orientation is updated on every sample, every AVG_STEP samples
+     * a running average and the current angles are added to the motion window
+     * @param int16_t *sample has one value per axis
+     * @param uint32_t time is the sample time in ms
+     * @return recognized symbol or 0
+     */
+    int16_t avg[MOTION_TRACKED];
+    int16_t angles[3];
+    uint8_t axis = 0;
+    char symbol = 0;
+    fusionUpdate(&orientation, sample);
+    if (boxcarPut(&avgFilter, sample, avg)) {
+        fusionAngles(&orientation, angles);
+        avg[MOTION_AXES + FUSION_ROLL] = angles[FUSION_ROLL];
+        avg[MOTION_AXES + FUSION_PITCH] = angles[FUSION_PITCH];
+        if (dataReadyNum < NUM_SAMPLES) {
+            dataReadyNum++;
+        }
+        for (; axis < MOTION_TRACKED; axis++) {
+            extremaPut(&motionExtrema[axis], avg[axis], dataIndex);
+        }
+        times[dataIndex] = time;
+        dataIndex = (dataIndex + 1) % NUM_SAMPLES;
+        // Check for possible correct moves on every new sample once we have a full window
+        // after a move the window has to be refilled with new samples
+        if (dataReadyNum >= NUM_SAMPLES) {
+            symbol = checkMoves();
+            if (symbol != 0) {
+                dataReadyNum = 0;
+            }
+        }
+    }
+    return symbol;
+}
@@ -0,0 +1,40 @@
+/*
+ * motion.h
+ *
+ *  Motion pipeline from MPU9250 samples to morse symbols.
+ *
+ *  Samples are int16 register counts with accelerometer bias removed,
+ *  in the order ax, ay, az, gx, gy, gz. They are averaged with a
+ *  boxcar filter and fused into an orientation at the full sample rate.
+ *  The extrema of the last MOTION_WINDOW ms are tracked per axis and
+ *  for roll and pitch, and the gesture table is checked on every new
+ *  average. Yaw has no reference and drifts, so it is not tracked.
+ *  The module has no RTOS or driver dependencies so recorded traces can
+ *  be replayed through the same code on a PC (see tools/replay.c).
+ *
+ */
+
+#ifndef MOTION_H_
+#define MOTION_H_
+
+#include <stdint.h>
+
+#define MOTION_AXES 6
+#define MOTION_ANGLES 2 // Roll and pitch from the orientation filter
+#define MOTION_TRACKED (MOTION_AXES + MOTION_ANGLES)
+#define MOTION_SAMPLE_PERIOD 5 // Input sample interval (ms), MPU at 200 Hz
+#define AVG_WIN_SIZE 3 // Window size for calculation averages from raw data, 3 samples at 200 Hz = 15 ms
+#define AVG_STEP AVG_WIN_SIZE // Raw samples between averages, AVG_WIN_SIZE for a tumbling window or 1 for sliding
+#define MOTION_WINDOW 300 // Time (ms) of motion data checked for moves
+#define NUM_SAMPLES (MOTION_WINDOW / (AVG_STEP * MOTION_SAMPLE_PERIOD)) // Max number of samples in motion data
+
+// Physical values into register counts for compile time thresholds, AFS_8G and GFS_250DPS
+#define MOTION_ACCEL_MG(mg) ((int16_t)(((int32_t)(mg) * 32768) / 8000))
+#define MOTION_GYRO_DPS(dps) ((int16_t)(((int32_t)(dps) * 32768) / 250))
+#define MOTION_ANGLE_DEG(deg) ((int16_t)(((int32_t)(deg) * 32768) / 180))
+
+void motionInit(void);
+void motionReset(void);
+char motionPut(const int16_t *sample, uint32_t time);
+
+#endif /* MOTION_H_ */
@@ -0,0 +1,111 @@
+/*
+ * msgpool.c
+ *
+ *  Static buffer pool for message arrays.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <xdc/std.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include "msgpool.h"
+
+#define CLASS0_SIZE MSG_POOL_MIN_SLOT_SIZE
+#define CLASS1_SIZE (MSG_POOL_MIN_SLOT_SIZE << 1)
+#define CLASS2_SIZE (MSG_POOL_MIN_SLOT_SIZE << 2)
+
+// Storage is reserved statically, uint32_t keeps the slots word aligned
+static uint32_t class0Storage[MSG_POOL_CLASS0_SLOTS * CLASS0_SIZE / sizeof(uint32_t)];
+static uint32_t class1Storage[MSG_POOL_CLASS1_SLOTS * CLASS1_SIZE / sizeof(uint32_t)];
+static uint32_t class2Storage[MSG_POOL_CLASS2_SLOTS * CLASS2_SIZE / sizeof(uint32_t)];
+
+static uint8_t *const STORAGE[MSG_POOL_CLASSES] = {(uint8_t *)class0Storage,
+                                                   (uint8_t *)class1Storage,
+                                                   (uint8_t *)class2Storage};
+static const uint16_t SLOT_SIZE[MSG_POOL_CLASSES] = {CLASS0_SIZE, CLASS1_SIZE, CLASS2_SIZE};
+static const uint8_t SLOT_COUNT[MSG_POOL_CLASSES] = {MSG_POOL_CLASS0_SLOTS,
+                                                     MSG_POOL_CLASS1_SLOTS,
+                                                     MSG_POOL_CLASS2_SLOTS};
+
+// Free slot indices of each class are kept as a stack
+static uint8_t freeSlots[MSG_POOL_CLASSES][MSG_POOL_MAX_SLOTS];
+static uint8_t freeCount[MSG_POOL_CLASSES];
+static uint8_t initialized = 0;
+static msgPoolStats stats;
+
+static void msgPoolInit() {
+    /*
+     * Puts every slot on the free stack of its class
+     */
+    uint8_t i = 0;
+    uint8_t j = 0;
+    for (; i < MSG_POOL_CLASSES; i++) {
+        j = 0;
+        for (; j < SLOT_COUNT[i]; j++) {
+            freeSlots[i][j] = SLOT_COUNT[i] - 1 - j;
+        }
+        freeCount[i] = SLOT_COUNT[i];
+    }
+    memset(&stats, 0, sizeof(stats));
+    initialized = 1;
+}
+
+void *msgPoolAcquire(uint16_t size, uint16_t *slotSize) {
+    /*
+     * Takes a free slot from the smallest class that fits size bytes
+     * @param uint16_t size is the minimum number of bytes needed
+     * @param uint16_t *slotSize output for the real size of the slot
+     * @return pointer to the slot or NULL if none is free
+     */
+    uint8_t *slot = NULL;
+    uint8_t i = 0;
+    UInt key = Hwi_disable();
+    if (!initialized) {
+        msgPoolInit();
+    }
+    for (; i < MSG_POOL_CLASSES; i++) {
+        if (SLOT_SIZE[i] >= size && freeCount[i] > 0) {
+            freeCount[i]--;
+            slot = STORAGE[i] + freeSlots[i][freeCount[i]] * SLOT_SIZE[i];
+            *slotSize = SLOT_SIZE[i];
+            stats.used[i]++;
+            if (stats.used[i] > stats.highWater[i]) {
+                stats.highWater[i] = stats.used[i];
+            }
+            break;
+        }
+    }
+    if (slot == NULL) {
+        stats.failures++;
+    }
+    Hwi_restore(key);
+    return slot;
+}
+
+void msgPoolRelease(void *slot) {
+    /*
+     * Returns a slot acquired with msgPoolAcquire back to the pool
+     */
+    uint8_t *ptr = (uint8_t *)slot;
+    uint8_t i = 0;
+    UInt key = Hwi_disable();
+    for (; i < MSG_POOL_CLASSES; i++) {
+        if (ptr >= STORAGE[i] && ptr < STORAGE[i] + SLOT_COUNT[i] * SLOT_SIZE[i]) {
+            freeSlots[i][freeCount[i]] = (ptr - STORAGE[i]) / SLOT_SIZE[i];
+            freeCount[i]++;
+            stats.used[i]--;
+            break;
+        }
+    }
+    Hwi_restore(key);
+}
+
+void msgPoolGetStats(msgPoolStats *dest) {
+    /*
+     * Copies slot usage, high-water marks and failed acquires into dest
+     */
+    UInt key = Hwi_disable();
+    memcpy(dest, &stats, sizeof(stats));
+    Hwi_restore(key);
+}
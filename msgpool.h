@@ -0,0 +1,34 @@
+/*
+ * msgpool.h
+ *
+ *  Static buffer pool for message arrays.
+ *
+ */
+
+#ifndef MSGPOOL_H_
+#define MSGPOOL_H_
+
+#include <stdint.h>
+
+// Slot classes, class n holds slots of MSG_POOL_MIN_SLOT_SIZE << n bytes
+#define MSG_POOL_CLASSES 3
+#define MSG_POOL_MIN_SLOT_SIZE 128
+#define MSG_POOL_CLASS0_SLOTS 4
+#define MSG_POOL_CLASS1_SLOTS 2
+#define MSG_POOL_CLASS2_SLOTS 1
+#define MSG_POOL_MAX_SLOTS 4
+#define MSG_POOL_MAX_SLOT_SIZE (MSG_POOL_MIN_SLOT_SIZE << (MSG_POOL_CLASSES - 1))
+
+// failures counts acquires that found no free slot, each one is an append
+// that was dropped or truncated when resizing a message
+typedef struct msgPoolStats {
+    uint8_t used[MSG_POOL_CLASSES];
+    uint8_t highWater[MSG_POOL_CLASSES];
+    uint16_t failures;
+} msgPoolStats;
+
+void *msgPoolAcquire(uint16_t size, uint16_t *slotSize);
+void msgPoolRelease(void *slot);
+void msgPoolGetStats(msgPoolStats *stats);
+
+#endif /* MSGPOOL_H_ */
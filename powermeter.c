@@ -0,0 +1,78 @@
+/*
+ * powermeter.c
+ *
+ *  Active, idle and standby time accounting.
+ *
+ */
+
+#include <stdint.h>
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/hal/Hwi.h>
+#include <ti/drivers/Power.h>
+#include <ti/drivers/power/PowerCC26XX.h>
+#include <driverlib/aon_rtc.h>
+#include "powermeter.h"
+
+static Power_NotifyObj standbyNotify;
+static uint32_t standbyStart = 0; // RTC in 16.16 seconds
+static uint32_t standbyRtc = 0;
+static uint16_t standbyCount = 0;
+
+static int standbyFxn(unsigned int eventType, uintptr_t eventArg, uintptr_t clientArg) {
+    // Called by the Power driver with interrupts disabled around standby
+    uint32_t now = AONRTCCurrentCompareValueGet();
+    if (eventType == PowerCC26XX_ENTERING_STANDBY) {
+        standbyStart = now;
+    } else {
+        standbyRtc += now - standbyStart;
+        standbyCount++;
+    }
+    return Power_NOTIFYDONE;
+}
+
+static uint32_t ticksToMs(uint32_t ticks) {
+    return (uint32_t)(((uint64_t)ticks * Clock_tickPeriod) / 1000);
+}
+
+void powerMeterInit(void) {
+    /*
+     * Registers for standby notifications, call once before BIOS_start
+     */
+    if (Power_registerNotify(&standbyNotify, PowerCC26XX_ENTERING_STANDBY | PowerCC26XX_AWAKE_STANDBY,
+                             standbyFxn, 0) != Power_SOK) {
+        System_abort("Error registering power notification!");
+    }
+}
+
+void powerMeterReset(void) {
+    /*
+     * Starts a new measurement window for all tasks
+     */
+    UInt key = Hwi_disable();
+    standbyRtc = 0;
+    standbyCount = 0;
+    Hwi_restore(key);
+    cpuMeterReset();
+}
+
+void powerMeterGet(powerReport *report) {
+    /*
+     * Fills report with the times since powerMeterReset
+     * Standby entered while a section is open counts as busy too
+     */
+    uint32_t used = 0;
+    uint8_t i = 0;
+    UInt key = Hwi_disable();
+    report->elapsed = ticksToMs(cpuMeterElapsedTicks());
+    report->busy = ticksToMs(cpuMeterUnionTicks());
+    report->standby = (uint32_t)(((uint64_t)standbyRtc * 1000) >> 16);
+    report->standbyCount = standbyCount;
+    Hwi_restore(key);
+    for (; i < CPU_METER_TASKS; i++) {
+        report->active[i] = ticksToMs(cpuMeterBusyTicks(i));
+    }
+    used = report->busy + report->standby;
+    report->idle = used < report->elapsed ? report->elapsed - used : 0;
+}
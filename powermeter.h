@@ -0,0 +1,36 @@
+/*
+ * powermeter.h
+ *
+ *  Active, idle and standby time accounting.
+ *
+ *  Builds on cpumeter: active time of each task comes from its
+ *  cpuMeterBegin/cpuMeterEnd sections. It is wall clock time including
+ *  waits inside the section, such as I2C transfers, and preemption by
+ *  other tasks, so the active times can add up to more than elapsed.
+ *  Standby is measured with the always-on RTC between the Power
+ *  driver's standby notifications, so it is exact even though the
+ *  kernel tick is suppressed meanwhile. Idle is the time when no
+ *  section was open and the device was not in standby.
+ *
+ */
+
+#ifndef POWERMETER_H_
+#define POWERMETER_H_
+
+#include <stdint.h>
+#include "cpumeter.h"
+
+typedef struct powerReport {
+    uint32_t elapsed;                 // All times in milliseconds since powerMeterReset
+    uint32_t active[CPU_METER_TASKS]; // Busy time of each task, may overlap
+    uint32_t busy;                    // Time when any task was busy
+    uint32_t idle;
+    uint32_t standby;
+    uint16_t standbyCount;            // Standby entries
+} powerReport;
+
+void powerMeterInit(void);
+void powerMeterReset(void);
+void powerMeterGet(powerReport *report);
+
+#endif /* POWERMETER_H_ */
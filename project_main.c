@@ -22,6 +22,8 @@
 #include <ti/sysbios/BIOS.h>
 #include <ti/sysbios/knl/Clock.h>
 #include <ti/sysbios/knl/Task.h>
+#include <ti/sysbios/knl/Event.h>
+#include <ti/sysbios/hal/Hwi.h>
 #include <ti/drivers/PIN.h>
 #include <ti/drivers/pin/PINCC26XX.h>
 #include <ti/drivers/i2c/I2CCC26XX.h>
@@ -29,15 +31,27 @@
 #include <ti/drivers/Power.h>
 #include <ti/drivers/power/PowerCC26XX.h>
 #include <ti/drivers/UART.h>
+#include <ti/drivers/uart/UARTCC26XX.h>
+#include <ti/drivers/SPI.h>
 
 /* Board Header files */
 #include "Board.h"
 #include "sensors/mpu9250.h"
 #include "buzzer.h"
+#include "sequencer.h"
+#include "toneprog.h"
+#include "morsetime.h"
 
 /* Extra header files */
 #include "message.h"
+#include "msgpool.h"
 #include "coders.h"
+#include "ringbuf.h"
+#include "link.h"
+#include "cpumeter.h"
+#include "powermeter.h"
+#include "motion.h"
+#include "extflash.h"
 
 // Task variables
 #define STACKSIZE 2048
@@ -46,63 +60,142 @@ Char uartTaskStack[STACKSIZE];
 Char buzzerStack[STACKSIZE];
 
 // Definition of the state machine
-enum state {INTERFACE=0, SENDING_DATA, WAITING, READING_DATA, RECEIVING_DATA, DATA_READY};
+enum state {INTERFACE=0, READING_DATA, DATA_READY};
 enum state programState = INTERFACE;
 
 // Constants
-#define NUM_SAMPLES 20 // Max number of samples in motion data
-#define AVG_WIN_SIZE 10 // Window size for calculation averages from raw data
-#define CLOCK_PERIOD 10 // Clock task interrupt period in milliseconds
-#define READ_WAIT 2000  // Wait time (ms) after last read character before repeating message to user
+#define MPU_FIFO_WATERMARK 10 // Samples collected in the MPU FIFO before the task drains them, 50 ms
+#define MPU_DATA_TIMEOUT 100 // Max wait (ms) for the FIFO watermark before draining anyway
+#define MORSE_DEFAULT_WPM 20 // Playback speed at boot, LINK_CMD_SET_WPM changes it
+#define MORSE_DOT_FREQ 8000
+#define MORSE_DASH_FREQ 2500
+#define RX_RING_SIZE 256 // Received characters waiting for the buzzer task, power of two
+#define RX_CHUNK_SIZE 16 // Max characters per UART read, shorter reads return on RX timeout
+#define UART_DEFAULT_BAUD 9600 // Baud rate at boot, LINK_CMD_SET_BAUD changes it
+#define UART_MIN_BAUD 1200
+#define UART_MAX_BAUD 460800
+#define UART_IDLE_TIMEOUT 2000 // Link silence (ms) before the UART is closed in low power mode
+#ifndef UART_LOW_POWER_DEFAULT
+// Low power mode at boot, LINK_CMD_LOW_POWER changes it. Off so no received byte is lost,
+// battery builds define it as 1 since the open UART keeps the device out of standby
+#define UART_LOW_POWER_DEFAULT 0
+#endif
+#define TX_RING_SIZE 64 // Detected symbols waiting for the UART task, power of two
+#define TX_MAX_BATCH 16 // Max symbols sent in one UART write
+#define TX_FLUSH_LATENCY 50 // Max time (ms) a symbol waits for more symbols before sending
+#define SAMPLE_RING_SIZE 1024 // Recorded sample frames waiting for the UART task, power of two
+#define REPLY_RING_SIZE 16 // Command replies waiting for the UART task, two bytes each, power of two
+#define SAMPLES_PER_FRAME 4 // Samples in one LINK_SAMPLES frame
+#define PLAY_CHUNK_STEPS 32 // Tone steps compiled at a time, two chunks are queued for gapless playback
+#define SONG_NOTE_GAP 50 // Rest (ms) after each note of the song
+#define SAMPLE_RECORD_SIZE 16 // uint32_t time and 6 int16_t values, little endian
+#define CALIBRATION_ADDR 0x7F000 // Last sector of the smallest (512 kB) external flash
 const char mario[] = "--.-.-...---";  // Send message "mario" via UART to play music
+#define SONG_STEPS 24 // Steps of the compiled song, two per note at most
+
+// Task wake up events
+#define EVENT_RX_DATA Event_Id_00       // Buzzer task: characters in rxRing
+#define EVENT_RX_DONE Event_Id_01       // Buzzer task: message gap passed since last character
+#define EVENT_PLAY_DONE Event_Id_02     // Buzzer task: sequencer finished a program
+#define EVENT_PLAY_CANCEL Event_Id_03   // Buzzer task: playback cancelled with button 1
+#define EVENT_TX_SYMBOL Event_Id_00     // UART task: symbol queued in txRing
+#define EVENT_TX_FLUSH Event_Id_01      // UART task: TX_FLUSH_LATENCY passed since symbol was queued
+#define EVENT_TX_DONE Event_Id_02       // UART task: UART write finished
+#define EVENT_LINK_SETTINGS Event_Id_03 // UART task: new link settings requested
+#define EVENT_TX_SAMPLES Event_Id_04    // UART task: recorded samples in sampleRing
+#define EVENT_UART_IDLE Event_Id_05     // UART task: UART_IDLE_TIMEOUT passed without link traffic
+#define EVENT_UART_WAKE Event_Id_06     // UART task: start bit on the RX pin while the UART is closed
+#define EVENT_LINK_REPLY Event_Id_07    // UART task: command reply queued in replyRing
+#define EVENT_MPU_START Event_Id_00     // MPU task: reading mode started
+#define EVENT_MPU_DATA Event_Id_01      // MPU task: MPU_FIFO_WATERMARK samples waiting in the MPU FIFO
+#define EVENT_MPU_CALIBRATE Event_Id_02 // MPU task: recalibration requested over the link
+
+// Task ids for cpumeter
+#define METER_MPU 0
+#define METER_UART 1
+#define METER_BUZZER 2
 
 // Buffers and message structs
-char txBuffer[4];
-char rxBuffer[10];
+char txRingStorage[TX_RING_SIZE];
+ringBuf txRing;
+char txBatch[TX_MAX_BATCH * 4];
+char rxBuffer[RX_CHUNK_SIZE];
+uint8_t txFrame[LINK_MAX_FRAME];
+char rxRingStorage[RX_RING_SIZE];
+ringBuf rxRing;
 msg TX_MESSAGE;
-msg RX_MESSAGE;
+morseMsg RX_MESSAGE;
 
 // Data arrays
-float rawData[6][AVG_WIN_SIZE];
-float motionData[6][NUM_SAMPLES];
-/* Data = [[ax_1, ax_2, ax_3, ...],
- *         [ay_1, ay_2, ay_3, ...],
- *         [az_1, az_2, az_3, ...],
- *         [gx_1, gx_2, gx_3, ...],
- *         [gy_1, gy_2, gy_3, ...],
- *         [gz_1, gz_2, gz_3, ...]]
- */
-uint32_t times[NUM_SAMPLES];
-uint32_t maxTimes[6];
-uint32_t minTimes[6];
-float maxValues[6];
-float minValues[6];
+toneStep playChunks[2][PLAY_CHUNK_STEPS];
+toneStep songProgram[SONG_STEPS];
+
+// Morse speed, playback steps and the end of message timeout follow it
+morseTiming timing;
+morseTones playTones;
+mpuBlock mpuSamples;
+char sampleRingStorage[SAMPLE_RING_SIZE];
+ringBuf sampleRing;
+uint8_t txSamples[4 * LINK_MAX_FRAME];
+char replyRingStorage[REPLY_RING_SIZE];
+ringBuf replyRing;
+uint8_t txReplies[LINK_MAX_FRAME];
 
 typedef struct Note {
-    uint16_t frequency;
+    buzzerTone tone;   // Timer values resolved at compile time with BUZZER_TONE
     uint16_t duration; // In milliseconds
 } Note;
 
 // ChatGPT provided notes
 // with prompt: "Give me 8-bit notes for mario in Note type of struct as a list."
-Note song[] = {{659, 150}, // E5
-               {659, 150}, // E5
-               {0,   150}, // REST
-               {659, 150}, // E5
-               {0,   150}, // REST
-               {523, 150}, // C5
-               {659, 150}, // E5
-               {0,   150}, // REST
-               {784, 300}, // G5
-               {0,   300}, // REST
-               {392, 300}};// G4
+const Note song[] = {{BUZZER_TONE(659), 150}, // E5
+                     {BUZZER_TONE(659), 150}, // E5
+                     {BUZZER_REST,      150}, // REST
+                     {BUZZER_TONE(659), 150}, // E5
+                     {BUZZER_REST,      150}, // REST
+                     {BUZZER_TONE(523), 150}, // C5
+                     {BUZZER_TONE(659), 150}, // E5
+                     {BUZZER_REST,      150}, // REST
+                     {BUZZER_TONE(784), 300}, // G5
+                     {BUZZER_REST,      300}, // REST
+                     {BUZZER_TONE(392), 300}};// G4
+const buzzerTone dotTone = BUZZER_TONE(MORSE_DOT_FREQ);
+const buzzerTone dashTone = BUZZER_TONE(MORSE_DASH_FREQ);
+const buzzerTone restTone = BUZZER_REST;
 
 // Variables
-uint8_t dataIndex = 0;
-uint8_t rawDataIndex = 0;
-uint32_t time = 0;
-uint32_t dataReadyTime = 0;
-uint8_t dataReadyNum = 0;
+volatile uint32_t mpuSampleTime = 0; // Time of the latest data ready interrupt
+volatile uint8_t mpuPendingSamples = 0; // Samples in the MPU FIFO since the last watermark event
+uint32_t nextSampleTime = 0; // Time of the next sample read from the MPU FIFO
+
+// Playback of RX_MESSAGE, programs finish in order so chunks are reused alternately
+uint16_t playIndex = 0; // Next element of RX_MESSAGE to compile
+uint8_t playQueued = 0; // Chunks queued to the sequencer and not finished
+uint8_t playChunk = 0; // Next chunk to compile into
+volatile uint8_t playFinished = 0; // Chunks finished since the buzzer task last checked
+
+// UART link settings, pending values are set by the buzzer task and applied by the UART task
+uint8_t linkMode = LINK_MODE_TEXT;
+uint32_t linkBaud = UART_DEFAULT_BAUD;
+volatile uint32_t pendingBaud = 0;
+volatile int8_t pendingMode = -1;
+volatile uint8_t uartReopening = 0;
+volatile uint8_t txBusy = 0;
+volatile uint8_t uartLowPower = UART_LOW_POWER_DEFAULT;
+uint8_t uartSleeping = 0; // UART closed and RX pin armed for wake up, UART task only
+uint8_t txFlushDue = 0;
+volatile uint8_t recording = 0; // Samples are sent as LINK_SAMPLES frames in binary mode
+linkParser rxParser;
+uint8_t rxInFrame = 0; // rxParser is inside a frame, buzzer task only
+uint8_t rxFrameStart = 1; // Text mode start byte begins a frame, set after a newline, a frame or the message gap
+
+// Task events and timeouts
+static Event_Handle buzzerEvent;
+static Event_Handle uartEvent;
+static Event_Handle mpuEvent;
+static Clock_Handle rxDoneClock = NULL;
+static Clock_Handle txFlushClock;
+static Clock_Handle uartIdleClock;
 
 // Pins RTOS-variables and configurations
 static PIN_Handle button0Handle;
@@ -111,7 +204,10 @@ static PIN_Handle button1Handle;
 static PIN_State button1State;
 static PIN_Handle ledHandle;
 static PIN_State ledState;
+static PIN_Handle rxWakeHandle;
+static PIN_State rxWakeState;
 static PIN_Handle mpuHandle;
+static PIN_State mpuState;
 static PIN_Handle hBuzzer;
 static PIN_State sBuzzer;
 static UART_Handle uart;
@@ -124,6 +220,7 @@ PIN_Config cBuzzer[] = {
 
 PIN_Config mpuPinConfig[] = {
     Board_MPU_POWER | PIN_GPIO_OUTPUT_EN | PIN_GPIO_HIGH | PIN_PUSHPULL | PIN_DRVSTR_MAX,
+    Board_MPU_INT | PIN_INPUT_EN | PIN_PULLDOWN | PIN_IRQ_DIS | PIN_HYSTERESIS, // Active high 50 us pulse
     PIN_TERMINATE
 };
 
@@ -142,6 +239,12 @@ PIN_Config powerButtonWakeConfig[] = {
    PIN_TERMINATE
 };
 
+// RX pin while the UART is closed, the start bit of any byte wakes the link
+PIN_Config rxWakeConfig[] = {
+   Board_UART_RX | PIN_INPUT_EN | PIN_PULLUP | PIN_IRQ_NEGEDGE,
+   PIN_TERMINATE
+};
+
 PIN_Config ledConfig[] = {
    Board_LED0 | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_PUSHPULL | PIN_DRVSTR_MAX,
    Board_LED1 | PIN_GPIO_OUTPUT_EN | PIN_GPIO_LOW | PIN_PUSHPULL | PIN_DRVSTR_MAX,
@@ -154,143 +257,281 @@ static const I2CCC26XX_I2CPinCfg i2cMPUCfg = {
     .pinSCL = Board_I2C0_SCL1
 };
 
-uint8_t isSong() {
-    if (programState == DATA_READY && RX_MESSAGE.count > 0) {
-        uint8_t i = 0;
-        for (; i < RX_MESSAGE.count; i++) {
-            if (RX_MESSAGE.data[i] != mario[i]) {
-                return 0;
-            }
-        }
-        return 1;
+uint32_t getTime() {
+    // Time in milliseconds, clock tick = 10us
+    return Clock_getTicks() / (1000 / Clock_tickPeriod);
+}
+
+void queueSymbol(const char symbol) {
+    /*
+     * Queues a detected symbol for the UART task
+     * Called from both the MPU task and the button callback, so the
+     * producer side of txRing is serialized with interrupts disabled
+     */
+    UInt key = Hwi_disable();
+    ringBufPut(&txRing, symbol);
+    Hwi_restore(key);
+    Event_post(uartEvent, EVENT_TX_SYMBOL);
+}
+
+void queueReply(uint8_t reply, uint8_t command) {
+    /*
+     * Queues an ack or nak of a link command for the UART task
+     * Called from the buzzer, MPU and UART tasks, both bytes are put with interrupts disabled
+     * @param reply: LINK_CMD_ACK or LINK_CMD_NAK
+     * @param command: id of the command replied to
+     */
+    UInt key = Hwi_disable();
+    if (REPLY_RING_SIZE - ringBufCount(&replyRing) >= 2) {
+        ringBufPut(&replyRing, reply);
+        ringBufPut(&replyRing, command);
     }
-    return 0;
+    Hwi_restore(key);
+    Event_post(uartEvent, EVENT_LINK_REPLY);
 }
 
-void movavg(float *fromArray, float *destArray) {
-    uint8_t i = 0;
-    float avg = 0;
-    while (i < AVG_WIN_SIZE) {
-        avg += fromArray[i];
-        i++;
+uint8_t setMorseSpeed(uint8_t wpm, uint8_t charWpm) {
+    /*
+     * Changes the playback durations and the end of message timeout
+     * @param charWpm: element speed for Farnsworth spacing, 0 for standard spacing
+     * @return 1 if the speed is valid
+     */
+    if (!morseTimingSet(&timing, wpm, charWpm)) {
+        return 0;
     }
-    destArray[dataIndex] = avg / AVG_WIN_SIZE;
+    toneProgMorseTones(&playTones, &timing, &dotTone, &dashTone);
+    if (rxDoneClock != NULL) {
+        // Timeout of a running clock can not be changed, restart it with the new one
+        uint8_t active = Clock_isActive(rxDoneClock);
+        Clock_stop(rxDoneClock);
+        Clock_setTimeout(rxDoneClock, ((uint32_t)timing.messageGap * 1000) / Clock_tickPeriod);
+        if (active) {
+            Clock_start(rxDoneClock);
+        }
+    }
+    return 1;
 }
 
-void getMaxMin() {
+void handleFrame(const linkParser *frame) {
+    /*
+     * Handles a complete frame received over the binary link
+     */
     uint8_t i = 0;
-    uint8_t j = 0;
-    for (; i < 6; i++) {
-        j = 0;
-        for (; j < NUM_SAMPLES; j++) {
-            if (j == 0) {
-                maxValues[i] = motionData[i][j];
-                minValues[i] = motionData[i][j];
-                continue;
+    if (frame->type == LINK_SYMBOLS) {
+        for (; i < frame->length; i++) {
+            morseMsgAppend(&RX_MESSAGE, frame->payload[i]);
+        }
+    } else if (frame->type == LINK_COMMAND && frame->length > 0) {
+        if (frame->payload[0] == LINK_CMD_SET_BAUD && frame->length == 5) {
+            uint32_t baud = (uint32_t)frame->payload[1] | ((uint32_t)frame->payload[2] << 8) |
+                            ((uint32_t)frame->payload[3] << 16) | ((uint32_t)frame->payload[4] << 24);
+            if (UART_MIN_BAUD <= baud && baud <= UART_MAX_BAUD) {
+                pendingBaud = baud;
+                Event_post(uartEvent, EVENT_LINK_SETTINGS);
+            } else {
+                queueReply(LINK_CMD_NAK, LINK_CMD_SET_BAUD);
+            }
+        } else if (frame->payload[0] == LINK_CMD_RECORD && frame->length == 2) {
+            recording = frame->payload[1] != 0;
+            queueReply(LINK_CMD_ACK, LINK_CMD_RECORD);
+        } else if (frame->payload[0] == LINK_CMD_CALIBRATE && frame->length == 1) {
+            // The MPU task acks when the calibration is stored
+            if (programState == READING_DATA) {
+                queueReply(LINK_CMD_NAK, LINK_CMD_CALIBRATE);
+            } else {
+                Event_post(mpuEvent, EVENT_MPU_CALIBRATE);
             }
-            if (motionData[i][j] > maxValues[i]) {
-                maxValues[i] = motionData[i][j];
-                maxTimes[i] = times[j];
+        } else if (frame->payload[0] == LINK_CMD_LOW_POWER && frame->length == 2) {
+            uartLowPower = frame->payload[1] != 0;
+            queueReply(LINK_CMD_ACK, LINK_CMD_LOW_POWER);
+        } else if (frame->payload[0] == LINK_CMD_SET_WPM && frame->length == 3) {
+            if (setMorseSpeed(frame->payload[1], frame->payload[2])) {
+                queueReply(LINK_CMD_ACK, LINK_CMD_SET_WPM);
+            } else {
+                queueReply(LINK_CMD_NAK, LINK_CMD_SET_WPM);
             }
-            if (motionData[i][j] < minValues[i]) {
-                minValues[i] = motionData[i][j];
-                minTimes[i] = times[j];
+        } else if (frame->payload[0] == LINK_CMD_SET_MODE && frame->length == 2) {
+            if (frame->payload[1] == LINK_MODE_TEXT || frame->payload[1] == LINK_MODE_BINARY) {
+                pendingMode = frame->payload[1];
+                Event_post(uartEvent, EVENT_LINK_SETTINGS);
+            } else {
+                queueReply(LINK_CMD_NAK, LINK_CMD_SET_MODE);
             }
+        } else {
+            // Unknown command or wrong payload length
+            queueReply(LINK_CMD_NAK, frame->payload[0]);
         }
     }
 }
 
-uint8_t checkMoves() {
-    getMaxMin();
-    // Turn to left
-    if (maxValues[1] > 0.6 && minValues[2] < 0.4) {
-        if (maxValues[3] > 90.0 && minValues[3] < -90.0) {
-            if (maxTimes[3] < minTimes[3]) {
-                sprintf(txBuffer, ".\r\n\0");
-                programState = SENDING_DATA;
-                return 1;
-            }
+uint16_t receiveData() {
+    /*
+     * Moves received characters from rxRing into RX_MESSAGE
+     * Called only from the buzzer task, so RX_MESSAGE is never touched by the UART callback
+     * Frames are recognized in both link modes, plain morse characters only in text mode
+     * @return number of morse elements added to RX_MESSAGE
+     */
+    uint16_t count = RX_MESSAGE.count;
+    uint8_t result;
+    char chr;
+    while (ringBufGet(&rxRing, &chr)) {
+        // In text mode a stray start byte in the middle of a line would swallow the
+        // following characters as a frame, so frames may only start a line there
+        result = LINK_PARSE_IDLE;
+        if (linkMode == LINK_MODE_BINARY || rxFrameStart || rxInFrame) {
+            result = linkParse(&rxParser, (uint8_t)chr);
         }
-    }
-    // Turn to right
-    if (minValues[1] < -0.6 && minValues[2] < 0.4) {
-        if (maxValues[3] > 90.0 && minValues[3] < -90.0) {
-            if (maxTimes[3] > minTimes[3]) {
-                sprintf(txBuffer, "-\r\n\0");
-                programState = SENDING_DATA;
-                return 1;
+        rxInFrame = result == LINK_PARSE_BUSY;
+        switch (result) {
+        case LINK_PARSE_IDLE:
+            if (linkMode == LINK_MODE_TEXT) {
+                morseMsgAppend(&RX_MESSAGE, chr);
             }
+            rxFrameStart = chr == '\n' || chr == '\r';
+            break;
+        case LINK_PARSE_DONE:
+            handleFrame(&rxParser);
+            rxFrameStart = 1;
+            break;
+        case LINK_PARSE_ERROR:
+            rxFrameStart = 0;
+            break;
         }
     }
-    return 0;
+    return RX_MESSAGE.count - count;
+}
+
+uint16_t compileSong(toneStep *program) {
+    /*
+     * Compiles the song with a rest after each note, rests are merged
+     * @return number of steps
+     */
+    uint16_t noteCount = sizeof(song) / sizeof(Note);
+    uint16_t steps = 0;
+    uint16_t i = 0;
+    for (; i < noteCount && steps + 2 <= SONG_STEPS; i++) {
+        steps = toneProgAdd(program, steps, &song[i].tone, song[i].duration);
+        steps = toneProgAdd(program, steps, &restTone, SONG_NOTE_GAP);
+    }
+    return steps;
+}
+
+void queueChunks() {
+    /*
+     * Compiles and queues chunks of RX_MESSAGE until both chunks are in use
+     */
+    while (playQueued < 2 && playIndex < RX_MESSAGE.count) {
+        uint16_t steps = toneProgCompileMorse(&RX_MESSAGE, &playIndex, &playTones,
+                                              playChunks[playChunk], PLAY_CHUNK_STEPS);
+        sequencerQueue(playChunks[playChunk], steps);
+        playChunk ^= 1;
+        playQueued++;
+    }
+}
+
+void startPlayback() {
+    /*
+     * Starts playing RX_MESSAGE, the task only refills chunks when they finish
+     */
+    playIndex = 0;
+    playQueued = 0;
+    playChunk = 0;
+    playFinished = 0;
+    // Known sequences play their stored program, others are compiled in chunks
+    uint16_t steps;
+    const toneStep *program = toneCacheFind(&RX_MESSAGE, &steps);
+    if (program != NULL) {
+        sequencerQueue(program, steps);
+        playQueued = 1;
+        playIndex = RX_MESSAGE.count;
+    } else {
+        queueChunks();
+    }
+}
+
+void endPlayback() {
+    /*
+     * Clears the played message and rechecks characters received meanwhile
+     */
+    morseMsgClear(&RX_MESSAGE);
+    PIN_setOutputValue(ledHandle, Board_LED1, 0);
+    programState = INTERFACE;
+    Event_post(buzzerEvent, EVENT_RX_DATA);
+}
+
+void playDoneFxn(const toneStep *program) {
+    // Called by the sequencer clock when a chunk has played
+    playFinished++;
+    Event_post(buzzerEvent, EVENT_PLAY_DONE);
 }
 
 Void buzzerFxn(UArg arg0, UArg arg1) {
+    UInt events;
     while (1) {
+        // Sleep until characters arrive, the message has ended or a chunk has played
+        // Messages are not drained during playback, the ring buffer keeps them
+        events = Event_pend(buzzerEvent, Event_Id_NONE,
+                            EVENT_RX_DATA | EVENT_RX_DONE | EVENT_PLAY_DONE | EVENT_PLAY_CANCEL,
+                            BIOS_WAIT_FOREVER);
+        cpuMeterBegin(METER_BUZZER);
+        if (events & EVENT_RX_DONE) {
+            rxFrameStart = 1;
+        }
         if (programState == DATA_READY) {
-            uint16_t i = 0;
-            if (isSong()) {
-                uint16_t noteCount = sizeof(song) / sizeof(Note);
-                for (; i < noteCount; i++) {
-                    if (song[i].frequency == 0) {
-                        delay(song[i].duration);
-                    } else {
-                        buzzerOpen(hBuzzer);
-                        buzzerSetFrequency(song[i].frequency);
-                        delay(song[i].duration);
-                        buzzerClose();
-                    }
-                    delay(50);
-                }
-            } else {
-                for(; i < RX_MESSAGE.count; i++) {
-                    if (RX_MESSAGE.data[i] == '.') {
-                        buzzerOpen(hBuzzer);
-                        buzzerSetFrequency(8000);
-                        delay(200);
-                        buzzerClose();
-                    }
-                    else if (RX_MESSAGE.data[i] == '-') {
-                        buzzerOpen(hBuzzer);
-                        buzzerSetFrequency(2500);
-                        delay(600);
-                        buzzerClose();
-                    }
-                    else if (RX_MESSAGE.data[i] == ' ') {
-                        buzzerOpen(hBuzzer);
-                        buzzerSetFrequency(1000);
-                        delay(1400);
-                        buzzerClose();
-                    }
-                    delay(400);
+            if (events & EVENT_PLAY_CANCEL) {
+                sequencerCancel();
+                endPlayback();
+            } else if (events & EVENT_PLAY_DONE) {
+                UInt key = Hwi_disable();
+                playQueued -= playFinished;
+                playFinished = 0;
+                Hwi_restore(key);
+                queueChunks();
+                if (playQueued == 0) {
+                    endPlayback();
                 }
             }
-            msgClear(&RX_MESSAGE);
-            PIN_setOutputValue(ledHandle, Board_LED1, 0);
-            programState = INTERFACE;
+        } else if ((events & EVENT_RX_DATA) && receiveData() > 0) {
+            PIN_setOutputValue(ledHandle, Board_LED1, 1);
+            // Restart the end of message timeout
+            Clock_stop(rxDoneClock);
+            Clock_start(rxDoneClock);
+        } else if ((events & EVENT_RX_DONE) && RX_MESSAGE.count > 0) {
+            programState = DATA_READY;
+            startPlayback();
         }
-        delay(100);
+        cpuMeterEnd(METER_BUZZER);
     }
 }
 
-Void clkFxn(UArg arg0) {
-   // Clock tick = 10us
-   time = Clock_getTicks() / 100; // Time in milliseconds
-   if (programState == RECEIVING_DATA || (dataReadyTime == 0  && programState == WAITING)) {
-       dataReadyTime = time;
-   }
-   if (dataReadyTime != 0) {
-       if (time < dataReadyTime || (time - dataReadyTime) > READ_WAIT) {
-           programState = DATA_READY;
-           dataReadyTime = 0;
-       }
-   }
+Void rxDoneFxn(UArg arg0) {
+    Event_post(buzzerEvent, EVENT_RX_DONE);
+}
+
+Void txFlushFxn(UArg arg0) {
+    Event_post(uartEvent, EVENT_TX_FLUSH);
+}
+
+Void uartIdleFxn(UArg arg0) {
+    Event_post(uartEvent, EVENT_UART_IDLE);
 }
 
 Void button1Fxn(PIN_Handle handle, PIN_Id pinId) {
     if (programState == READING_DATA) {
-        sprintf(txBuffer, " \r\n\0");
-        programState = SENDING_DATA;
+        queueSymbol(' ');
+    } else if (programState == DATA_READY) {
+        Event_post(buzzerEvent, EVENT_PLAY_CANCEL);
+    }
+}
+
+void mpuIntFxn(PIN_Handle handle, PIN_Id pinId) {
+    // Data ready, the sample is already in the FIFO
+    // Timestamp it here and wake the task only at the watermark
+    mpuSampleTime = getTime();
+    mpuPendingSamples++;
+    if (mpuPendingSamples >= MPU_FIFO_WATERMARK) {
+        mpuPendingSamples = 0;
+        Event_post(mpuEvent, EVENT_MPU_DATA);
     }
 }
 
@@ -299,6 +540,7 @@ void button0Fxn(PIN_Handle handle, PIN_Id pinId) {
         if (programState == INTERFACE) {
             PIN_setOutputValue(ledHandle, Board_LED0, 1);
             programState = READING_DATA;
+            Event_post(mpuEvent, EVENT_MPU_START);
         } else if (programState == READING_DATA) {
             PIN_setOutputValue(ledHandle, Board_LED0, 0);
             programState = INTERFACE;
@@ -307,39 +549,49 @@ void button0Fxn(PIN_Handle handle, PIN_Id pinId) {
 }
 
 void readCallback(UART_Handle uart, void *buffer, size_t len) {
+    // Only enqueue here, the buzzer task drains rxRing into RX_MESSAGE
     char *receivedChr = (char *)buffer;
-    programState = RECEIVING_DATA;
-
-    if (PIN_getOutputValue(Board_LED1) == 0) {
-        PIN_setOutputValue(ledHandle, Board_LED1, 1);
+    size_t i = 0;
+    for (; i < len; i++) {
+        ringBufPut(&rxRing, receivedChr[i]);
     }
-    if (receivedChr[0] == ' ' || receivedChr[0] == '-' || receivedChr[0] == '.') {
-        msgAppend(&RX_MESSAGE, receivedChr[0]);
-
+    if (len > 0) {
+        Event_post(buzzerEvent, EVENT_RX_DATA);
+        Clock_stop(uartIdleClock);
+        Clock_start(uartIdleClock);
+    }
+    if (!uartReopening) {
+        UART_read(uart, rxBuffer, RX_CHUNK_SIZE);
     }
-    programState = WAITING;
-    dataReadyTime = time;
-    UART_read(uart, rxBuffer, 1);
 }
 
 
 void writeCallback(UART_Handle uart, void *buffer, size_t len) {
-    programState = READING_DATA;
+    txBusy = 0;
+    Clock_stop(uartIdleClock);
+    Clock_start(uartIdleClock);
+    Event_post(uartEvent, EVENT_TX_DONE);
+    if (programState == READING_DATA) {
+        PIN_setOutputValue(ledHandle, Board_LED0, 1);
+    }
 }
 
+void openUart() {
+    /*
+     * Opens UART with the current linkBaud and linkMode and starts reading
+     * Text mode uses text data conversions, binary mode passes frames through untouched
+     */
+    uint8_t dataMode = (linkMode == LINK_MODE_BINARY) ? UART_DATA_BINARY : UART_DATA_TEXT;
 
-Void uartTaskFxn(UArg arg0, UArg arg1) {
-
-    // Initialize UART parameters
     UART_Params_init(&uartParams);
-    uartParams.writeDataMode = UART_DATA_TEXT;
+    uartParams.writeDataMode = dataMode;
     uartParams.writeMode = UART_MODE_CALLBACK;
     uartParams.writeCallback = writeCallback;
-    uartParams.readDataMode = UART_DATA_TEXT;
+    uartParams.readDataMode = dataMode;
     uartParams.readEcho = UART_ECHO_OFF;
     uartParams.readMode = UART_MODE_CALLBACK;
     uartParams.readCallback = readCallback;
-    uartParams.baudRate = 9600;
+    uartParams.baudRate = linkBaud;
     uartParams.dataLength = UART_LEN_8;
     uartParams.parityType = UART_PAR_NONE;
     uartParams.stopBits = UART_STOP_ONE;
@@ -349,21 +601,329 @@ Void uartTaskFxn(UArg arg0, UArg arg1) {
     if (uart == NULL) {
         System_abort("Error in opening UART");
     }
-    UART_read(uart, rxBuffer, 1);
+    // Return partial reads when the line goes idle, so a read callback
+    // handles a whole burst of characters instead of one byte
+    if (UART_control(uart, UARTCC26XX_CMD_RETURN_PARTIAL_ENABLE, NULL) < 0) {
+        System_abort("Error enabling UART partial reads");
+    }
+    uartReopening = 0;
+    UART_read(uart, rxBuffer, RX_CHUNK_SIZE);
+    Clock_stop(uartIdleClock);
+    Clock_start(uartIdleClock);
+}
+
+void rxWakeFxn(PIN_Handle handle, PIN_Id pinId) {
+    // Start bit while the UART is closed, the task reopens it
+    PIN_setInterrupt(handle, Board_UART_RX | PIN_IRQ_DIS);
+    Event_post(uartEvent, EVENT_UART_WAKE);
+}
+
+void sleepUart() {
+    /*
+     * Closes UART when the link is idle so that its RX power constraint
+     * no longer keeps the device out of standby. A falling edge on the RX
+     * pin reopens it, bytes received until UART is open again are lost.
+     */
+    if (!uartLowPower || uartSleeping) {
+        return;
+    }
+    if (txBusy || programState == READING_DATA || ringBufCount(&txRing) > 0 || ringBufCount(&sampleRing) > 0 ||
+        ringBufCount(&replyRing) > 0) {
+        // Link still in use, try again after the next timeout
+        Clock_start(uartIdleClock);
+        return;
+    }
+    uartReopening = 1;
+    UART_close(uart);
+    rxWakeHandle = PIN_open(&rxWakeState, rxWakeConfig);
+    if (rxWakeHandle == NULL || PIN_registerIntCb(rxWakeHandle, &rxWakeFxn) != 0) {
+        System_abort("Error initializing UART wake up pin!");
+    }
+    uartSleeping = 1;
+}
+
+void wakeUart() {
+    /*
+     * Reopens UART closed by sleepUart
+     */
+    PIN_close(rxWakeHandle);
+    uartSleeping = 0;
+    openUart();
+}
+
+void sendReplies() {
+    /*
+     * Sends all queued command replies as ack or nak frames with a single UART write
+     */
+    uint16_t len = 0;
+    char reply;
+    char command;
+    while (len + 2 + LINK_OVERHEAD <= sizeof(txReplies) && ringBufGet(&replyRing, &reply)) {
+        uint8_t payload[2];
+        ringBufGet(&replyRing, &command);
+        payload[0] = reply;
+        payload[1] = command;
+        len += linkEncode(LINK_COMMAND, payload, sizeof(payload), txReplies + len);
+    }
+    if (len == 0) {
+        return;
+    }
+    txBusy = 1;
+    if (UART_write(uart, txReplies, len) < 0) {
+        txBusy = 0;
+    }
+}
+
+void applyLinkSettings() {
+    /*
+     * Reopens UART with the settings requested over the link
+     * and acknowledges each applied setting with the new settings
+     */
+    uint8_t baudApplied = 0;
+    uint8_t modeApplied = 0;
+    if (pendingBaud != 0) {
+        linkBaud = pendingBaud;
+        baudApplied = 1;
+        pendingBaud = 0;
+    }
+    if (pendingMode >= 0) {
+        linkMode = pendingMode;
+        modeApplied = 1;
+        pendingMode = -1;
+    }
+    uartReopening = 1;
+    UART_close(uart);
+    openUart();
+    if (baudApplied) {
+        queueReply(LINK_CMD_ACK, LINK_CMD_SET_BAUD);
+    }
+    if (modeApplied) {
+        queueReply(LINK_CMD_ACK, LINK_CMD_SET_MODE);
+    }
+    // Closing UART cancelled any write in progress
+    sendReplies();
+}
+
+void flushSymbols() {
+    /*
+     * Sends up to TX_MAX_BATCH queued symbols with a single UART write
+     * Text mode keeps the per symbol format "x\r\n\0", binary mode sends one symbols frame
+     */
+    uint8_t symbols[TX_MAX_BATCH];
+    uint8_t count = 0;
+    uint16_t len = 0;
+    char chr;
+    while (count < TX_MAX_BATCH && ringBufGet(&txRing, &chr)) {
+        symbols[count] = chr;
+        count++;
+    }
+    if (count == 0) {
+        return;
+    }
+    PIN_setOutputValue(ledHandle, Board_LED0, 0);
+    txBusy = 1;
+    int8_t wBytes;
+    if (linkMode == LINK_MODE_BINARY) {
+        len = linkEncode(LINK_SYMBOLS, symbols, count, txFrame);
+        wBytes = UART_write(uart, txFrame, len);
+    } else {
+        uint8_t i = 0;
+        for (; i < count; i++) {
+            txBatch[len++] = symbols[i];
+            txBatch[len++] = '\r';
+            txBatch[len++] = '\n';
+            txBatch[len++] = '\0';
+        }
+        wBytes = UART_write(uart, txBatch, len);
+    }
+    if (wBytes < 0) {
+        System_abort("Error in UART_write");
+    }
+}
+
+void sendSamples() {
+    /*
+     * Sends queued sample frames, symbols are sent first
+     */
+    uint16_t len = 0;
+    char byte;
+    while (len < sizeof(txSamples) && ringBufGet(&sampleRing, &byte)) {
+        txSamples[len++] = byte;
+    }
+    if (len == 0) {
+        return;
+    }
+    txBusy = 1;
+    if (UART_write(uart, txSamples, len) < 0) {
+        System_abort("Error in UART_write");
+    }
+}
+
+Void uartTaskFxn(UArg arg0, UArg arg1) {
+
+    UInt events;
+    uint16_t queued;
+
+    openUart();
     while (1) {
-        if(programState == SENDING_DATA) {
-            PIN_setOutputValue(ledHandle, Board_LED0, 0);
-            // Send data string with UART
-            int8_t wBytes = UART_write(uart, txBuffer, 4);
-            if (wBytes < 0) {
-                System_abort("Error in UART_write");
+        events = Event_pend(uartEvent, Event_Id_NONE,
+                            EVENT_TX_SYMBOL | EVENT_TX_FLUSH | EVENT_TX_DONE | EVENT_LINK_SETTINGS |
+                            EVENT_TX_SAMPLES | EVENT_UART_IDLE | EVENT_UART_WAKE | EVENT_LINK_REPLY,
+                            BIOS_WAIT_FOREVER);
+        cpuMeterBegin(METER_UART);
+        // Anything but the idle timeout needs the UART open
+        if (uartSleeping && (events & ~EVENT_UART_IDLE)) {
+            wakeUart();
+        }
+        if (events & EVENT_LINK_SETTINGS) {
+            applyLinkSettings();
+        }
+        // Replies go first, the host may be waiting for them
+        if (!txBusy) {
+            sendReplies();
+        }
+        if (events & EVENT_TX_FLUSH) {
+            txFlushDue = 1;
+        }
+        // Coalesce symbols that arrive within TX_FLUSH_LATENCY into one write
+        queued = ringBufCount(&txRing);
+        if (queued == 0) {
+            txFlushDue = 0;
+        } else if (!txBusy && (queued >= TX_MAX_BATCH || txFlushDue)) {
+            Clock_stop(txFlushClock);
+            flushSymbols();
+            txFlushDue = 0;
+        }
+        if (ringBufCount(&txRing) > 0 && !txFlushDue && !Clock_isActive(txFlushClock)) {
+            Clock_start(txFlushClock);
+        }
+        // Recorded samples use the link whenever symbols do not
+        if (!txBusy) {
+            sendSamples();
+        }
+        if (events & EVENT_UART_IDLE) {
+            sleepUart();
+        }
+        cpuMeterEnd(METER_UART);
+    }
+}
+
+void processSample(uint8_t sample, uint32_t time) {
+    /*
+     * Moves a sample of the block forward in the motion pipeline
+     * and queues the symbol of a recognized move
+     */
+    int16_t value[MOTION_AXES];
+    uint8_t axis = 0;
+    for (; axis < MOTION_AXES; axis++) {
+        value[axis] = mpuSamples.raw[axis][sample];
+    }
+    char symbol = motionPut(value, time);
+    if (symbol != 0) {
+        queueSymbol(symbol);
+    }
+}
+
+void recordBlock(const mpuBlock *block) {
+    /*
+     * Queues the samples of a block as LINK_SAMPLES frames for the UART task
+     * A frame is queued only if it fits whole, otherwise it is counted as dropped
+     */
+    uint8_t payload[SAMPLES_PER_FRAME * SAMPLE_RECORD_SIZE];
+    uint8_t frame[LINK_MAX_FRAME];
+    uint8_t i = 0;
+    while (i < block->count) {
+        uint8_t len = 0;
+        uint8_t n = 0;
+        for (; n < SAMPLES_PER_FRAME && i < block->count; n++, i++) {
+            uint32_t time = block->times[i];
+            payload[len++] = time;
+            payload[len++] = time >> 8;
+            payload[len++] = time >> 16;
+            payload[len++] = time >> 24;
+            uint8_t axis = 0;
+            for (; axis < MOTION_AXES; axis++) {
+                payload[len++] = block->raw[axis][i];
+                payload[len++] = (uint16_t)block->raw[axis][i] >> 8;
             }
-            delay(250);
-            PIN_setOutputValue(ledHandle, Board_LED0, 1);
         }
-        // Once per second, you can modify this
-        delay(100);
+        uint8_t frameLen = linkEncode(LINK_SAMPLES, payload, len, frame);
+        if (SAMPLE_RING_SIZE - ringBufCount(&sampleRing) < frameLen) {
+            ringBufDrop(&sampleRing);
+            continue;
+        }
+        uint8_t j = 0;
+        for (; j < frameLen; j++) {
+            ringBufPut(&sampleRing, frame[j]);
+        }
+    }
+    Event_post(uartEvent, EVENT_TX_SAMPLES);
+}
+
+void drainFifo(I2C_Handle *i2cMPU) {
+    /*
+     * Reads all samples waiting in the MPU FIFO as blocks of burst reads
+     * Sample times are counted forward at MOTION_SAMPLE_PERIOD and
+     * synchronized to the latest data ready interrupt after the FIFO is empty
+     */
+    uint8_t count;
+    do {
+        count = mpu9250_read_block(i2cMPU, &mpuSamples);
+        uint8_t i = 0;
+        for (; i < count; i++) {
+            mpuSamples.times[i] = nextSampleTime;
+            nextSampleTime += MOTION_SAMPLE_PERIOD;
+        }
+        // Pipeline works on register counts, only accelerometer bias is removed
+        mpu9250_remove_bias(&mpuSamples);
+        for (i = 0; i < count && programState == READING_DATA; i++) {
+            processSample(i, mpuSamples.times[i]);
+        }
+        if (recording && linkMode == LINK_MODE_BINARY && count > 0) {
+            recordBlock(&mpuSamples);
+        }
+    } while (count == MPU9250_BLOCK_LEN && programState == READING_DATA);
+    nextSampleTime = mpuSampleTime + MOTION_SAMPLE_PERIOD;
+}
+
+uint8_t loadCalibration(mpu9250Calibration *cal) {
+    /*
+     * Reads the MPU9250 calibration from the external flash
+     * @return 1 if a valid calibration was found
+     */
+    uint8_t ok = extFlashOpen();
+    if (ok) {
+        ok = extFlashRead(CALIBRATION_ADDR, (uint8_t *)cal, sizeof(mpu9250Calibration));
+        extFlashClose();
     }
+    return ok && mpu9250_calibration_valid(cal);
+}
+
+void saveCalibration() {
+    /*
+     * Stores the calibration of the last mpu9250_setup to the external flash,
+     * a failure only costs a full calibration on the next boot
+     */
+    mpu9250Calibration cal;
+    mpu9250_get_calibration(&cal);
+    uint8_t ok = extFlashOpen();
+    if (ok) {
+        ok = extFlashErase(CALIBRATION_ADDR) &&
+             extFlashWrite(CALIBRATION_ADDR, (const uint8_t *)&cal, sizeof(cal));
+        extFlashClose();
+    }
+    System_printf(ok ? "MPU9250: Calibration saved\n" : "MPU9250: Calibration not saved\n");
+    System_flush();
+}
+
+void calibrate(I2C_Handle *i2cMPU) {
+    /*
+     * Runs self test and calibration, the device must be kept still
+     */
+    mpu9250_setup(i2cMPU);
+    System_printf("MPU9250: Setup and calibration OK\n");
+    System_flush();
+    saveCalibration();
 }
 
 Void mpuTaskFxn(UArg arg0, UArg arg1) {
@@ -396,41 +956,64 @@ Void mpuTaskFxn(UArg arg0, UArg arg1) {
     // Setup the OPT3001 sensor for use
     // Before calling the setup function, insert 100ms delay with Task_sleep
     delay(100);
-    mpu9250_setup(&i2cMPU);
-    System_printf("MPU9250: Setup and calibration OK\n");
-    System_flush();
+    // Stored calibration skips the self test and calibration, only the first
+    // boot or a failed validation needs the device to be kept still
+    mpu9250Calibration cal;
+    if (loadCalibration(&cal)) {
+        mpu9250_setup_fast(&i2cMPU, &cal);
+        System_printf("MPU9250: Setup with stored calibration OK\n");
+        System_flush();
+    } else {
+        calibrate(&i2cMPU);
+    }
+
+    uint8_t metering = 0;
 
     while (1) {
-        // Read sensor data and save the sensor values into the global variable
-        if(programState == READING_DATA) {
-            mpu9250_get_data(&i2cMPU, &rawData[0][rawDataIndex],
-                             &rawData[1][rawDataIndex],
-                             &rawData[2][rawDataIndex],
-                             &rawData[3][rawDataIndex],
-                             &rawData[4][rawDataIndex],
-                             &rawData[5][rawDataIndex]);
-            rawDataIndex = (rawDataIndex + 1) % AVG_WIN_SIZE;
-            if (rawDataIndex == 0) {
-                if (dataReadyNum < 20) {
-                    dataReadyNum++;
-                }
-                // Calculate 10 value average from raw values
-                uint8_t i = 0;
-                for(;i < 6; i++) {
-                    movavg(rawData[i], motionData[i]);
-                }
-                times[dataIndex] = time;
-                dataIndex = (dataIndex + 1) % NUM_SAMPLES;
-                // Check for possible correct moves if we have atleast 20 samples
-                // after that check every fifth new samples for moves
-                if (dataIndex % 5 == 0 && dataReadyNum >= 20) {
-                    if (checkMoves() == true) {
-                        dataReadyNum = 0;
-                    }
+        if (programState != READING_DATA) {
+            // Report power states of the reading session and sleep until the next one
+            PIN_setInterrupt(mpuHandle, Board_MPU_INT | PIN_IRQ_DIS);
+            mpu9250_fifo_stop(&i2cMPU);
+            if (metering) {
+                powerReport report;
+                powerMeterGet(&report);
+                System_printf("%u ms: active MPU %u, UART %u, buzzer %u ms, any %u ms, idle %u ms, standby %u ms (%u)\n",
+                              report.elapsed, report.active[METER_MPU], report.active[METER_UART],
+                              report.active[METER_BUZZER], report.busy, report.idle, report.standby,
+                              report.standbyCount);
+                msgPoolStats pool;
+                msgPoolGetStats(&pool);
+                System_printf("Message pool high water %u/%u/%u slots, %u failed\n",
+                              pool.highWater[0], pool.highWater[1], pool.highWater[2], pool.failures);
+                System_flush();
+            }
+            while (programState != READING_DATA) {
+                UInt events = Event_pend(mpuEvent, Event_Id_NONE, EVENT_MPU_START | EVENT_MPU_CALIBRATE,
+                                         BIOS_WAIT_FOREVER);
+                if ((events & EVENT_MPU_CALIBRATE) && programState != READING_DATA) {
+                    calibrate(&i2cMPU);
+                    queueReply(LINK_CMD_ACK, LINK_CMD_CALIBRATE);
                 }
             }
+            powerMeterReset();
+            metering = 1;
+            mpuPendingSamples = 0;
+            nextSampleTime = getTime();
+            motionReset();
+            mpu9250_fifo_start(&i2cMPU);
+            PIN_clrPendInterrupt(mpuHandle, Board_MPU_INT);
+            PIN_setInterrupt(mpuHandle, Board_MPU_INT | PIN_IRQ_POSEDGE);
         }
-        delay(1); // Sleep 1ms
+        // Sleep until the MPU FIFO reaches the watermark, samples are never lost
+        // if the task is late since the FIFO holds 42 samples
+        Event_pend(mpuEvent, Event_Id_NONE, EVENT_MPU_DATA,
+                   (MPU_DATA_TIMEOUT*1000) / Clock_tickPeriod);
+        cpuMeterBegin(METER_MPU);
+        // Drain on timeout too, in case a watermark event was missed
+        if (programState == READING_DATA) {
+            drainFifo(&i2cMPU);
+        }
+        cpuMeterEnd(METER_MPU);
     }
 }
 
@@ -443,8 +1026,8 @@ Int main(void) {
     Task_Handle uartTaskHandle;
     Task_Params uartTaskParams;
 
-    Clock_Handle clkHandle;
     Clock_Params clkParams;
+    Event_Params eventParams;
 
     Task_Handle buzzerTaskHandle;
     Task_Params buzzerParams;
@@ -458,20 +1041,29 @@ Int main(void) {
     // Initialize UART
     Board_initUART();
 
-    // Initialize clock
-    Clock_Params_init(&clkParams);
-    clkParams.period = (CLOCK_PERIOD*1000) / Clock_tickPeriod;
-    clkParams.startFlag = TRUE;
+    // Initialize SPI for the external flash
+    Board_initSPI();
+
+    // Count standby time for the power report
+    powerMeterInit();
 
     // Initialize message structs
     msgInit(&TX_MESSAGE);
-    msgInit(&RX_MESSAGE);
+    morseMsgInit(&RX_MESSAGE);
+    ringBufInit(&rxRing, rxRingStorage, RX_RING_SIZE);
+    linkParserInit(&rxParser);
+    ringBufInit(&txRing, txRingStorage, TX_RING_SIZE);
+    ringBufInit(&sampleRing, sampleRingStorage, SAMPLE_RING_SIZE);
+    ringBufInit(&replyRing, replyRingStorage, REPLY_RING_SIZE);
+    motionInit();
 
     // Initialize Buzzer handle
     hBuzzer = PIN_open(&sBuzzer, cBuzzer);
     if (hBuzzer == NULL) {
       System_abort("Error buzzer pin failed to open!");
     }
+    sequencerInit(hBuzzer, playDoneFxn);
+    toneCacheAdd(mario, songProgram, compileSong(songProgram));
 
     // Open LED handle
     ledHandle = PIN_open(&ledState, ledConfig);
@@ -479,12 +1071,39 @@ Int main(void) {
        System_abort("Error initializing LED pin!");
     }
 
-    // Create clock handle
-    clkHandle = Clock_create((Clock_FuncPtr)clkFxn, clkParams.period, &clkParams, NULL);
-    if (clkHandle == NULL) {
+    // Create task events
+    Event_Params_init(&eventParams);
+    buzzerEvent = Event_create(&eventParams, NULL);
+    uartEvent = Event_create(&eventParams, NULL);
+    mpuEvent = Event_create(&eventParams, NULL);
+    if (buzzerEvent == NULL || uartEvent == NULL || mpuEvent == NULL) {
+       System_abort("Error event creation failed!");
+    }
+
+    // Create one-shot clocks for end of message, TX flush and link idle timeouts
+    Clock_Params_init(&clkParams);
+    clkParams.period = 0;
+    clkParams.startFlag = FALSE;
+    setMorseSpeed(MORSE_DEFAULT_WPM, 0);
+    rxDoneClock = Clock_create((Clock_FuncPtr)rxDoneFxn, ((uint32_t)timing.messageGap * 1000) / Clock_tickPeriod,
+                               &clkParams, NULL);
+    txFlushClock = Clock_create((Clock_FuncPtr)txFlushFxn, (TX_FLUSH_LATENCY*1000) / Clock_tickPeriod, &clkParams, NULL);
+    uartIdleClock = Clock_create((Clock_FuncPtr)uartIdleFxn, (UART_IDLE_TIMEOUT*1000) / Clock_tickPeriod, &clkParams, NULL);
+    if (rxDoneClock == NULL || txFlushClock == NULL || uartIdleClock == NULL) {
        System_abort("Error clock creation failed!");
     }
 
+    // Open MPU power and interrupt pins
+    mpuHandle = PIN_open(&mpuState, mpuPinConfig);
+    if (!mpuHandle) {
+       System_abort("Error initializing MPU pins!");
+    }
+
+    // Register data ready interrupt function for MPU, enabled in reading mode
+    if (PIN_registerIntCb(mpuHandle, &mpuIntFxn) != 0) {
+       System_abort("Error registering MPU callback function!");
+    }
+
     // Create button0 handle
     button0Handle = PIN_open(&button0State, button0Config);
     if(!button0Handle) {
@@ -538,36 +1157,37 @@ Int main(void) {
 
     // Check that encoding and decoding works correctly
     char greeting[] = "Hello world";
-    uint8_t i = 0;
-    for(; i < (uint8_t) strlen(greeting); i++) {
-        msgAppend(&TX_MESSAGE, greeting[i]);
-    }
+    msgAppendStr(&TX_MESSAGE, greeting);
     encode(TX_MESSAGE.data, &RX_MESSAGE, TX_MESSAGE.count);
 
+    // Unpack the encoded message into TX_MESSAGE for printing
+    msgClear(&TX_MESSAGE);
+    morseMsgUnpack(&RX_MESSAGE, &TX_MESSAGE);
+
     System_printf("\n");
     System_printf(greeting);
     System_printf(" == ");
-    System_printf(RX_MESSAGE.data);
+    System_printf(msgString(&TX_MESSAGE));
     System_printf("\n");
 
+    System_printf(msgString(&TX_MESSAGE));
+    System_printf("== ");
     msgClear(&TX_MESSAGE);
-    decode(RX_MESSAGE.data, &TX_MESSAGE, RX_MESSAGE.count);
+    decode(&RX_MESSAGE, &TX_MESSAGE);
 
-    System_printf(RX_MESSAGE.data);
-    System_printf("== ");
-    System_printf(TX_MESSAGE.data);
+    System_printf(msgString(&TX_MESSAGE));
     System_printf("\n");
     System_flush();
 
     msgClear(&TX_MESSAGE);
-    msgClear(&RX_MESSAGE);
+    morseMsgClear(&RX_MESSAGE);
 
     // Start BIOS
     BIOS_start();
 
     // Add these into the shutdown function
     // to free the memory
-    // msgDestroy(&RX_MESSAGE);
+    // morseMsgDestroy(&RX_MESSAGE);
     // msgDestroy(&TX_MESSAGE);
     // Also set message pointers to NULL
 
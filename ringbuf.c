@@ -0,0 +1,85 @@
+/*
+ * ringbuf.c
+ *
+ *  Lock-free single-producer/single-consumer ring buffer.
+ *
+ */
+
+#include <stdint.h>
+#include "ringbuf.h"
+
+// On the single core device volatile accesses keep the order of data and
+// index writes. Multicore PC builds (tools/ringstress.c) define
+// RINGBUF_FENCES to order them with C11 fences.
+#ifdef RINGBUF_FENCES
+#include <stdatomic.h>
+#define RING_ACQUIRE() atomic_thread_fence(memory_order_acquire)
+#define RING_RELEASE() atomic_thread_fence(memory_order_release)
+#else
+#define RING_ACQUIRE()
+#define RING_RELEASE()
+#endif
+
+void ringBufInit(ringBuf *ring, char *storage, uint16_t size) {
+    /*
+     * Initializes an empty ring buffer
+     * @param char *storage is the buffer memory
+     * @param uint16_t size is the storage size, must be a power of two
+     */
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    ring->mask = size - 1;
+    ring->data = storage;
+}
+
+uint8_t ringBufPut(ringBuf *ring, const char chr) {
+    /*
+     * Producer side, adds a character to the buffer
+     * @return 1 on success, 0 if the buffer was full and chr was dropped
+     */
+    uint16_t head = ring->head;
+    if ((uint16_t)(head - ring->tail) > ring->mask) {
+        ring->dropped++;
+        return 0;
+    }
+    // The consumer has read the slot before it published tail
+    RING_ACQUIRE();
+    ring->data[head & ring->mask] = chr;
+    // Data is written before the index is published to the consumer
+    RING_RELEASE();
+    ring->head = head + 1;
+    return 1;
+}
+
+void ringBufDrop(ringBuf *ring) {
+    /*
+     * Producer side, counts a record the producer dropped without putting
+     * any of it, e.g. a frame that does not fit whole
+     */
+    ring->dropped++;
+}
+
+uint8_t ringBufGet(ringBuf *ring, char *chr) {
+    /*
+     * Consumer side, takes the oldest character from the buffer
+     * @return 1 on success, 0 if the buffer was empty
+     */
+    uint16_t tail = ring->tail;
+    if (tail == ring->head) {
+        return 0;
+    }
+    RING_ACQUIRE();
+    *chr = ring->data[tail & ring->mask];
+    // The slot is read before it is handed back to the producer
+    RING_RELEASE();
+    ring->tail = tail + 1;
+    return 1;
+}
+
+uint16_t ringBufCount(const ringBuf *ring) {
+    /*
+     * Number of characters waiting in the buffer
+     */
+    return (uint16_t)(ring->head - ring->tail);
+}
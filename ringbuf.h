@@ -0,0 +1,31 @@
+/*
+ * ringbuf.h
+ *
+ *  Lock-free single-producer/single-consumer ring buffer.
+ *
+ *  The producer (e.g. an interrupt callback) only calls ringBufPut and
+ *  ringBufDrop and the consumer task only calls ringBufGet. Each side writes only its
+ *  own index, so no locking is needed on a single core.
+ *
+ */
+
+#ifndef RINGBUF_H_
+#define RINGBUF_H_
+
+#include <stdint.h>
+
+typedef struct ringBuf {
+    volatile uint16_t head;     // Written only by the producer
+    volatile uint16_t tail;     // Written only by the consumer
+    volatile uint16_t dropped;  // Characters, or whole records of ringBufDrop, lost because the buffer was full
+    uint16_t mask;
+    volatile char *data;
+} ringBuf;
+
+void ringBufInit(ringBuf *ring, char *storage, uint16_t size);
+uint8_t ringBufPut(ringBuf *ring, const char chr);
+void ringBufDrop(ringBuf *ring);
+uint8_t ringBufGet(ringBuf *ring, char *chr);
+uint16_t ringBufCount(const ringBuf *ring);
+
+#endif /* RINGBUF_H_ */
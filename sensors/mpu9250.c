@@ -495,6 +495,102 @@ void MPU9250SelfTest(float * destination) // Should return percent deviation fro
 
 /**************** JTKJ: DO NOT MODIFY ANYTHING ABOVE THIS LINE ****************/
 
+#include <stddef.h>
+#include <string.h>
+
+#define MAX_GYRO_BIAS 50.0 // Max believable gyro bias (deg/s)
+#define MAX_ACCEL_BIAS 1.0 // Max believable accelerometer bias (g)
+
+static uint32_t calibrationCrc(const mpu9250Calibration *cal) {
+
+	// Bitwise CRC-32 (polynomial 0xEDB88320) over everything but the crc field
+	const uint8_t *data = (const uint8_t *)cal;
+	uint16_t len = offsetof(mpu9250Calibration, crc);
+	uint32_t crc = 0xFFFFFFFF;
+	uint16_t ii;
+	uint8_t bit;
+	for (ii = 0; ii < len; ii++) {
+		crc ^= data[ii];
+		for (bit = 0; bit < 8; bit++) {
+			crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+		}
+	}
+	return ~crc;
+}
+
+void mpu9250_setup_fast(I2C_Handle *i2c_orig, const mpu9250Calibration *cal) {
+
+	uint16_t ii;
+	i2c = *i2c_orig;
+
+	System_printf("MPU9250: Setup from stored calibration...\n");
+	System_flush();
+
+	getAres();
+	getGres();
+
+	for (ii = 0; ii < 3; ii++) {
+		gyroBias[ii] = cal->gyroBias[ii];
+		accelBias[ii] = cal->accelBias[ii];
+	}
+	for (ii = 0; ii < 6; ii++) {
+		SelfTest[ii] = cal->selfTest[ii];
+	}
+
+	initMPU9250();
+
+	// Offset registers are cleared at power up, load the stored gyro biases
+	writeByte( XG_OFFSET_H, (cal->gyroOffset[0] >> 8) & 0xFF);
+	writeByte( XG_OFFSET_L, cal->gyroOffset[0] & 0xFF);
+	writeByte( YG_OFFSET_H, (cal->gyroOffset[1] >> 8) & 0xFF);
+	writeByte( YG_OFFSET_L, cal->gyroOffset[1] & 0xFF);
+	writeByte( ZG_OFFSET_H, (cal->gyroOffset[2] >> 8) & 0xFF);
+	writeByte( ZG_OFFSET_L, cal->gyroOffset[2] & 0xFF);
+
+	System_printf("MPU9250: Setup OK\n");
+	System_flush();
+}
+
+void mpu9250_get_calibration(mpu9250Calibration *cal) {
+
+	// Results of the latest mpu9250_setup, gyro offsets as written by accelgyrocalMPU9250
+	uint8_t data[6];
+	uint16_t ii;
+
+	memset(cal, 0, sizeof(mpu9250Calibration));
+	cal->magic = MPU9250_CALIBRATION_MAGIC;
+	cal->version = MPU9250_CALIBRATION_VERSION;
+	cal->length = sizeof(mpu9250Calibration);
+
+	readByte( XG_OFFSET_H, 6, data);
+	for (ii = 0; ii < 3; ii++) {
+		cal->gyroOffset[ii] = (int16_t)(((int16_t)data[2*ii] << 8) | data[2*ii + 1]);
+		cal->gyroBias[ii] = gyroBias[ii];
+		cal->accelBias[ii] = accelBias[ii];
+	}
+	for (ii = 0; ii < 6; ii++) {
+		cal->selfTest[ii] = SelfTest[ii];
+	}
+	cal->crc = calibrationCrc(cal);
+}
+
+uint8_t mpu9250_calibration_valid(const mpu9250Calibration *cal) {
+
+	uint16_t ii;
+
+	if (cal->magic != MPU9250_CALIBRATION_MAGIC || cal->version != MPU9250_CALIBRATION_VERSION ||
+	    cal->length != sizeof(mpu9250Calibration) || cal->crc != calibrationCrc(cal)) {
+		return 0;
+	}
+	// Calibration done while moving is not worth keeping, self test results are only stored
+	for (ii = 0; ii < 3; ii++) {
+		if (!(fabs(cal->gyroBias[ii]) <= MAX_GYRO_BIAS) || !(fabs(cal->accelBias[ii]) <= MAX_ACCEL_BIAS)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
 void mpu9250_get_data(I2C_Handle *i2c, float *ax, float *ay, float *az, float *gx, float *gy, float *gz) {
 
 	uint8_t rawData[14]; // Register data
@@ -520,3 +616,111 @@ void mpu9250_get_data(I2C_Handle *i2c, float *ax, float *ay, float *az, float *g
 	*gy = (float)my*gRes;
 	*gz = (float)mz*gRes;
 }
+
+static uint8_t fifoBuffer[MPU9250_BLOCK_LEN * MPU9250_FIFO_FRAME];
+static int16_t accelBiasCounts[3]; // accelBias in register counts for the integer pipeline
+
+void mpu9250_fifo_start(I2C_Handle *i2c) {
+
+	// Accelerometer bias as counts, float is needed only here
+	uint16_t ii;
+	for (ii = 0; ii < 3; ii++) {
+		accelBiasCounts[ii] = (int16_t)(accelBias[ii] / aRes);
+	}
+
+	// Discard old FIFO contents and stream accel and gyro frames into the FIFO
+	writeByte( FIFO_EN, 0x00);      // Stop writing while resetting
+	writeByte( USER_CTRL, 0x04);    // Reset FIFO (bit 2)
+	writeByte( USER_CTRL, 0x40);    // Enable FIFO (bit 6)
+	writeByte( FIFO_EN, 0x78);      // Accel and gyro x, y, z into FIFO, 12 bytes per sample
+}
+
+void mpu9250_fifo_stop(I2C_Handle *i2c) {
+
+	writeByte( FIFO_EN, 0x00);      // Stop writing samples into FIFO
+	writeByte( USER_CTRL, 0x04);    // Reset FIFO
+}
+
+uint8_t mpu9250_read_block(I2C_Handle *i2c, mpuBlock *block) {
+
+	uint8_t data[2];
+	uint16_t fifo_count, frame_count;
+
+	block->count = 0;
+
+	// Read number of bytes in FIFO
+	readByte( FIFO_COUNTH, 2, data);
+	fifo_count = (((uint16_t)data[0] << 8) | data[1]) & 0x1FFF;
+
+	// Nearly full FIFO has overwritten old samples and frames are no longer aligned, start over
+	if (fifo_count > MPU9250_FIFO_SIZE - MPU9250_FIFO_FRAME) {
+		mpu9250_fifo_start(i2c);
+		return 0;
+	}
+
+	frame_count = fifo_count / MPU9250_FIFO_FRAME;
+	if (frame_count > MPU9250_BLOCK_LEN) {
+		frame_count = MPU9250_BLOCK_LEN;
+	}
+	if (frame_count == 0) {
+		return 0;
+	}
+
+	// All frames in one burst, FIFO_R_W is not auto incremented
+	readByte( FIFO_R_W, frame_count * MPU9250_FIFO_FRAME, fifoBuffer);
+
+	// Split the interleaved big endian frames into one array per axis
+	uint16_t axis, ii;
+	for (axis = 0; axis < 6; axis++) {
+		const uint8_t *src = &fifoBuffer[axis * 2];
+		int16_t *dest = block->raw[axis];
+		for (ii = 0; ii < frame_count; ii++) {
+			dest[ii] = (int16_t)(((int16_t)src[0] << 8) | src[1]);
+			src += MPU9250_FIFO_FRAME;
+		}
+	}
+	block->count = frame_count;
+	return frame_count;
+}
+
+void mpu9250_remove_bias(mpuBlock *block) {
+
+	uint16_t axis, ii;
+
+	// Accelerometer bias is removed without leaving register counts
+	// A saturated reading stays at full scale instead of wrapping around
+	for (axis = 0; axis < 3; axis++) {
+		int16_t *raw = block->raw[axis];
+		int32_t bias = accelBiasCounts[axis];
+		for (ii = 0; ii < block->count; ii++) {
+			int32_t value = (int32_t)raw[ii] - bias;
+			if (value > INT16_MAX) {
+				value = INT16_MAX;
+			} else if (value < INT16_MIN) {
+				value = INT16_MIN;
+			}
+			raw[ii] = (int16_t)value;
+		}
+	}
+}
+
+void mpu9250_convert_block(const mpuBlock *block, float data[6][MPU9250_BLOCK_LEN]) {
+
+	uint16_t axis, ii;
+
+	// Accelerometer counts into g, gyroscope counts into degrees per second
+	// One axis at a time so each loop is a plain multiply-add over an array
+	for (axis = 0; axis < 3; axis++) {
+		const int16_t *raw = block->raw[axis];
+		float bias = accelBias[axis];
+		for (ii = 0; ii < block->count; ii++) {
+			data[axis][ii] = (float)raw[ii]*aRes - bias;
+		}
+	}
+	for (axis = 3; axis < 6; axis++) {
+		const int16_t *raw = block->raw[axis];
+		for (ii = 0; ii < block->count; ii++) {
+			data[axis][ii] = (float)raw[ii]*gRes;
+		}
+	}
+}
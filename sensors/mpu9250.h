@@ -14,8 +14,44 @@
 
 #include <ti/drivers/I2C.h>
 
+#define MPU9250_FIFO_SIZE 512
+#define MPU9250_FIFO_FRAME 12 // Accel and gyro x, y, z as big endian int16
+#define MPU9250_BLOCK_LEN 21 // Max samples per block, one I2C burst with 8-bit read count
+
+// Calibration results, stored so that boot can skip self test and calibration
+#define MPU9250_CALIBRATION_MAGIC 0x4D505543 // "MPUC"
+#define MPU9250_CALIBRATION_VERSION 1
+
+typedef struct mpu9250Calibration {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t length;        // sizeof(mpu9250Calibration)
+    int16_t gyroOffset[3];  // Gyro offset register values
+    int16_t reserved;
+    float gyroBias[3];      // deg/s
+    float accelBias[3];     // g
+    float selfTest[6];      // % deviation from factory trim
+    uint32_t crc;           // CRC-32 of the fields above
+} mpu9250Calibration;
+
+// Block of samples from the FIFO, one array per axis
+typedef struct mpuBlock {
+    uint8_t count;
+    int16_t raw[6][MPU9250_BLOCK_LEN]; // ax, ay, az, gx, gy, gz register values
+    uint32_t times[MPU9250_BLOCK_LEN]; // Sample times, filled by the caller
+} mpuBlock;
+
 void mpu9250_setup(I2C_Handle *i2c);
 void mpu9250_get_data(I2C_Handle *i2c, float *ax, float *ay, float *az, float *gx, float *gy, float *gz);
+void mpu9250_setup_fast(I2C_Handle *i2c, const mpu9250Calibration *cal);
+void mpu9250_get_calibration(mpu9250Calibration *cal);
+uint8_t mpu9250_calibration_valid(const mpu9250Calibration *cal);
+void mpu9250_fifo_start(I2C_Handle *i2c);
+void mpu9250_fifo_stop(I2C_Handle *i2c);
+uint8_t mpu9250_read_block(I2C_Handle *i2c, mpuBlock *block);
+// Either removes accelerometer bias in counts or converts into g and deg/s, not both
+void mpu9250_remove_bias(mpuBlock *block);
+void mpu9250_convert_block(const mpuBlock *block, float data[6][MPU9250_BLOCK_LEN]);
 void delay(uint16_t delay);
 
 #endif /* MPU9250_H_ */
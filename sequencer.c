@@ -0,0 +1,167 @@
+/*
+ * sequencer.c
+ *
+ *  Timer driven buzzer playback.
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <xdc/std.h>
+#include <xdc/runtime/System.h>
+#include <ti/sysbios/knl/Clock.h>
+#include <ti/sysbios/hal/Hwi.h>
+
+#include "buzzer.h"
+#include "sequencer.h"
+
+typedef struct seqProgram {
+    const toneStep *steps;
+    uint16_t count;
+} seqProgram;
+
+static Clock_Handle stepClock = NULL;
+static PIN_Handle hPin = NULL;
+static sequencerDoneFxn doneFxn = NULL;
+
+static seqProgram queue[SEQ_QUEUE_LEN];
+static uint8_t queueHead = 0;
+static uint8_t queueCount = 0;
+static seqProgram current = {NULL, 0};
+static uint16_t stepIndex = 0;
+static uint8_t buzzerIsOpen = 0;
+
+static void advance(void) {
+    /*
+     * Starts the next step with a duration, taking programs from the queue
+     * Called with interrupts disabled or from the step Clock callback
+     */
+    const toneStep *step = NULL;
+    while (step == NULL) {
+        if (current.steps == NULL) {
+            if (queueCount == 0) {
+                // Queue empty, release the PWM and its power dependency
+                if (buzzerIsOpen) {
+                    buzzerClose();
+                    buzzerIsOpen = 0;
+                }
+                return;
+            }
+            current = queue[queueHead];
+            queueHead = (queueHead + 1) & (SEQ_QUEUE_LEN - 1);
+            queueCount--;
+            stepIndex = 0;
+        }
+        if (stepIndex < current.count) {
+            step = &current.steps[stepIndex++];
+            if (step->duration == 0) {
+                step = NULL;
+            }
+        } else {
+            const toneStep *finished = current.steps;
+            current.steps = NULL;
+            if (doneFxn != NULL) {
+                doneFxn(finished);
+            }
+        }
+    }
+
+    if (!BUZZER_IS_REST(&step->tone)) {
+        if (!buzzerIsOpen) {
+            buzzerOpen(hPin);
+            buzzerIsOpen = 1;
+        }
+        buzzerSetTone(&step->tone);
+    } else if (buzzerIsOpen) {
+        buzzerSilence();
+    }
+    Clock_setTimeout(stepClock, ((uint32_t)step->duration * 1000) / Clock_tickPeriod);
+    Clock_start(stepClock);
+}
+
+static Void stepFxn(UArg arg0) {
+    // Previous step has ended
+    advance();
+}
+
+static void dropAll(void) {
+    /*
+     * Forgets the current and queued programs without releasing the PWM
+     * Called with interrupts disabled
+     */
+    Clock_stop(stepClock);
+    current.steps = NULL;
+    queueCount = 0;
+}
+
+void sequencerInit(PIN_Handle buzzerPin, sequencerDoneFxn done) {
+    /*
+     * Creates the step clock, call from main before BIOS_start
+     * @param buzzerPin: opened handle of the buzzer pin
+     * @param done: called when a program has played to the end, or NULL
+     */
+    Clock_Params clkParams;
+    Clock_Params_init(&clkParams);
+    clkParams.period = 0;
+    clkParams.startFlag = FALSE;
+    stepClock = Clock_create((Clock_FuncPtr)stepFxn, 1, &clkParams, NULL);
+    if (stepClock == NULL) {
+        System_abort("Error sequencer clock creation failed!");
+    }
+    hPin = buzzerPin;
+    doneFxn = done;
+}
+
+uint8_t sequencerQueue(const toneStep *program, uint16_t count) {
+    /*
+     * Plays program after the programs already queued, starts at once when idle
+     * @param program: steps, must stay valid until done is called for it
+     * @param count: number of steps
+     * @return 1 if queued, 0 if the queue is full
+     */
+    UInt key = Hwi_disable();
+    if (queueCount == SEQ_QUEUE_LEN) {
+        Hwi_restore(key);
+        return 0;
+    }
+    queue[(queueHead + queueCount) & (SEQ_QUEUE_LEN - 1)].steps = program;
+    queue[(queueHead + queueCount) & (SEQ_QUEUE_LEN - 1)].count = count;
+    queueCount++;
+    if (current.steps == NULL) {
+        advance();
+    }
+    Hwi_restore(key);
+    return 1;
+}
+
+void sequencerPreempt(const toneStep *program, uint16_t count) {
+    /*
+     * Stops the current playback, drops the queue and plays program at once
+     * The PWM is not closed in between
+     */
+    UInt key = Hwi_disable();
+    dropAll();
+    queue[queueHead].steps = program;
+    queue[queueHead].count = count;
+    queueCount = 1;
+    advance();
+    Hwi_restore(key);
+}
+
+void sequencerCancel(void) {
+    /*
+     * Stops the current playback and drops the queue
+     */
+    UInt key = Hwi_disable();
+    dropAll();
+    advance();
+    Hwi_restore(key);
+}
+
+uint8_t sequencerBusy(void) {
+    /*
+     * @return 1 if a program is playing or queued
+     */
+    return current.steps != NULL || queueCount > 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * sequencer.h
+ *
+ *  Timer driven buzzer playback.
+ *
+ *  A program is an array of tone steps. Steps are advanced from a
+ *  one-shot Clock callback, so the caller never waits for playback.
+ *  The buzzer PWM stays open from the first tone of a program until
+ *  the queue is empty, rests only silence the output. The program
+ *  array must stay valid until its done callback has been called.
+ *
+ */
+
+#ifndef SEQUENCER_H_
+#define SEQUENCER_H_
+
+#include <stdint.h>
+#include <ti/drivers/PIN.h>
+#include "buzzer.h"
+
+#define SEQ_QUEUE_LEN 4 // Programs waiting to play, power of two
+
+typedef struct toneStep {
+    buzzerTone tone;   // BUZZER_REST for a rest
+    uint16_t duration; // In milliseconds
+} toneStep;
+
+// Called from the Clock callback when a program has played to the end,
+// not for programs dropped by sequencerPreempt or sequencerCancel
+typedef void (*sequencerDoneFxn)(const toneStep *program);
+
+void sequencerInit(PIN_Handle buzzerPin, sequencerDoneFxn done);
+uint8_t sequencerQueue(const toneStep *program, uint16_t count);
+void sequencerPreempt(const toneStep *program, uint16_t count);
+void sequencerCancel(void);
+uint8_t sequencerBusy(void);
+
+#endif /* SEQUENCER_H_ */
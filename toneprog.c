@@ -0,0 +1,124 @@
+/*
+ * toneprog.c
+ *
+ *  Compilation of morse messages and melodies into sequencer programs.
+ *
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "toneprog.h"
+
+typedef struct toneCacheEntry {
+    uint32_t hash;
+    uint16_t count; // Elements in the message
+    uint16_t steps;
+    const toneStep *program; // NULL for an empty entry
+} toneCacheEntry;
+
+static toneCacheEntry cache[TONE_CACHE_SIZE];
+static const buzzerTone REST = BUZZER_REST;
+
+uint16_t toneProgAdd(toneStep *program, uint16_t steps, const buzzerTone *tone, uint16_t duration) {
+    /*
+     * Appends a step to program, a rest after a rest only lengthens it
+     * Capacity for one more step must be checked by the caller
+     * @param tone: resolved tone or BUZZER_REST, copied into the step
+     * @return number of steps in program
+     */
+    if (BUZZER_IS_REST(tone) && steps > 0 && BUZZER_IS_REST(&program[steps - 1].tone) &&
+        (uint32_t)program[steps - 1].duration + duration <= 0xFFFF) {
+        program[steps - 1].duration += duration;
+        return steps;
+    }
+    program[steps].tone = *tone;
+    program[steps].duration = duration;
+    return steps + 1;
+}
+
+void toneProgMorseTones(morseTones *tones, const morseTiming *timing, const buzzerTone *dot, const buzzerTone *dash) {
+    /*
+     * Builds the element steps for a timing, spaces are silent
+     * A space after a letter lengthens the element gap to the letter gap
+     * and a second space the letter gap to the word gap
+     * @param dot, dash: resolved tones of the elements
+     */
+    tones->element[MORSE_DOT].tone = *dot;
+    tones->element[MORSE_DOT].duration = timing->dot;
+    tones->element[MORSE_DASH].tone = *dash;
+    tones->element[MORSE_DASH].duration = timing->dash;
+    tones->element[MORSE_SPACE].tone = REST;
+    tones->element[MORSE_SPACE].duration = timing->letterGap - timing->elementGap;
+    tones->gap = timing->elementGap;
+    tones->wordSpace = timing->wordGap - timing->letterGap;
+}
+
+uint16_t toneProgCompileMorse(const morseMsg *message, uint16_t *index, const morseTones *tones,
+                              toneStep *program, uint16_t maxSteps) {
+    /*
+     * Compiles elements of message from *index on until program is full
+     * @param index: first element to compile, updated to the next one
+     * @param maxSteps: capacity of program, at least 2
+     * @return number of steps
+     */
+    uint16_t steps = 0;
+    uint8_t previous = *index > 0 ? morseMsgGetCode(message, *index - 1) : MORSE_DOT;
+    for (; *index < message->count && steps + 2 <= maxSteps; (*index)++) {
+        uint8_t code = morseMsgGetCode(message, *index);
+        const toneStep *tone = &tones->element[code];
+        if (code == MORSE_SPACE) {
+            uint16_t duration = previous == MORSE_SPACE ? tones->wordSpace : tone->duration;
+            steps = toneProgAdd(program, steps, &tone->tone, duration);
+        } else {
+            steps = toneProgAdd(program, steps, &tone->tone, tone->duration);
+            steps = toneProgAdd(program, steps, &REST, tones->gap);
+        }
+        previous = code;
+    }
+    return steps;
+}
+
+uint8_t toneCacheAdd(const char *morse, const toneStep *program, uint16_t steps) {
+    /*
+     * Stores a compiled program to be played for the message morse
+     * @param morse: '.', '-' and ' ' characters of the message
+     * @param program: compiled steps, must stay valid
+     * @return 1 if stored, 0 if the cache is full
+     */
+    uint32_t hash = morseStrHash(morse);
+    uint16_t count = 0;
+    uint8_t slot = hash & (TONE_CACHE_SIZE - 1);
+    uint8_t i = 0;
+    for (; *morse != '\0'; morse++) {
+        count += *morse == '.' || *morse == '-' || *morse == ' ';
+    }
+    for (; i < TONE_CACHE_SIZE; i++, slot = (slot + 1) & (TONE_CACHE_SIZE - 1)) {
+        if (cache[slot].program == NULL) {
+            cache[slot].hash = hash;
+            cache[slot].count = count;
+            cache[slot].steps = steps;
+            cache[slot].program = program;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+const toneStep *toneCacheFind(const morseMsg *message, uint16_t *steps) {
+    /*
+     * Looks up the program stored for message
+     * @param steps: set to the number of steps when found
+     * @return program or NULL
+     */
+    uint32_t hash = morseMsgHash(message);
+    uint8_t slot = hash & (TONE_CACHE_SIZE - 1);
+    uint8_t i = 0;
+    for (; i < TONE_CACHE_SIZE && cache[slot].program != NULL;
+         i++, slot = (slot + 1) & (TONE_CACHE_SIZE - 1)) {
+        if (cache[slot].hash == hash && cache[slot].count == message->count) {
+            *steps = cache[slot].steps;
+            return cache[slot].program;
+        }
+    }
+    return NULL;
+}
@@ -0,0 +1,39 @@
+/*
+ * toneprog.h
+ *
+ *  Compilation of morse messages and melodies into sequencer programs.
+ *
+ *  Steps are appended with toneProgAdd, which merges consecutive rests
+ *  so that a program has at most one rest between two tones. Known
+ *  sequences, such as the song played for "mario", are compiled once and
+ *  kept in a cache keyed by the morse hash of the message that plays
+ *  them. A lookup compares only the hash and the element count, so a
+ *  different message colliding with a known one in 32 bits would play it.
+ *
+ */
+
+#ifndef TONEPROG_H_
+#define TONEPROG_H_
+
+#include <stdint.h>
+#include "message.h"
+#include "sequencer.h"
+#include "morsetime.h"
+
+#define TONE_CACHE_SIZE 8 // Known sequences, power of two
+
+// Step for each morse element code, dots and dashes are followed by a rest of gap ms
+typedef struct morseTones {
+    toneStep element[3]; // MORSE_DOT, MORSE_DASH, MORSE_SPACE
+    uint16_t gap;
+    uint16_t wordSpace;  // Duration of a space after a space
+} morseTones;
+
+uint16_t toneProgAdd(toneStep *program, uint16_t steps, const buzzerTone *tone, uint16_t duration);
+void toneProgMorseTones(morseTones *tones, const morseTiming *timing, const buzzerTone *dot, const buzzerTone *dash);
+uint16_t toneProgCompileMorse(const morseMsg *message, uint16_t *index, const morseTones *tones,
+                              toneStep *program, uint16_t maxSteps);
+uint8_t toneCacheAdd(const char *morse, const toneStep *program, uint16_t steps);
+const toneStep *toneCacheFind(const morseMsg *message, uint16_t *steps);
+
+#endif /* TONEPROG_H_ */
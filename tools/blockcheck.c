@@ -0,0 +1,165 @@
+/*
+ * blockcheck.c
+ *
+ *  PC side check of the MPU9250 block pipeline: FIFO block read, bias
+ *  removal in register counts and the conversion pass into g and deg/s.
+ *
+ *  Build and run on the PC, not part of the SensorTag project:
+ *    gcc -O2 -Ihost -I.. -I../sensors -o blockcheck blockcheck.c ../sensors/mpu9250.c -lm
+ *    ./blockcheck [-r repeats]
+ *
+ *  The driver is built against the stand-ins in host/ and talks to a
+ *  simulated MPU9250 that answers FIFO_COUNTH and FIFO_R_W from a frame
+ *  queue. A stored calibration with an accelerometer bias is loaded,
+ *  then frames including full scale values are read back block by
+ *  block. mpu9250_convert_block must match the conversion in double
+ *  precision and mpu9250_remove_bias the saturating subtraction of the
+ *  bias in counts. Reported is the conversion time per sample, the exit
+ *  status is 1 on a mismatch.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#include "mpu9250.h"
+
+#define FIFO_COUNTH 0x72 // Registers of the simulated FIFO, as in mpu9250.c
+#define FIFO_R_W 0x74
+#define USER_CTRL 0x6A
+#define FRAMES 30
+#define ACCEL_RES (8.0 / 32768.0)   // g per count, AFS_8G
+#define GYRO_RES (250.0 / 32768.0)  // deg/s per count, GFS_250DPS
+
+static uint8_t fifo[MPU9250_FIFO_SIZE];
+static uint16_t fifoHead = 0;
+static uint16_t fifoCount = 0;
+
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction) {
+    /*
+     * Simulated MPU9250, only the FIFO registers return data
+     */
+    const uint8_t *tx = (const uint8_t *)transaction->writeBuf;
+    uint8_t *rx = (uint8_t *)transaction->readBuf;
+    size_t i = 0;
+    if (transaction->writeCount == 2 && tx[0] == USER_CTRL && (tx[1] & 0x04)) {
+        fifoHead = 0;
+        fifoCount = 0;
+    }
+    if (transaction->readCount == 0) {
+        return true;
+    }
+    memset(rx, 0, transaction->readCount);
+    if (tx[0] == FIFO_COUNTH && transaction->readCount == 2) {
+        rx[0] = fifoCount >> 8;
+        rx[1] = fifoCount & 0xFF;
+    } else if (tx[0] == FIFO_R_W) {
+        for (; i < transaction->readCount && fifoCount > 0; i++) {
+            rx[i] = fifo[fifoHead++];
+            fifoCount--;
+        }
+    }
+    return true;
+}
+
+static void pushFrame(const int16_t *sample) {
+    uint8_t axis = 0;
+    for (; axis < 6; axis++) {
+        fifo[fifoHead + fifoCount++] = (uint16_t)sample[axis] >> 8;
+        fifo[fifoHead + fifoCount++] = sample[axis] & 0xFF;
+    }
+}
+
+static int16_t sampleValue(uint16_t frame, uint8_t axis) {
+    // Full scale values on the accelerometer so the bias has to saturate
+    if (axis < 3 && frame % 10 == 3) {
+        return INT16_MAX;
+    }
+    if (axis < 3 && frame % 10 == 7) {
+        return INT16_MIN;
+    }
+    return (int16_t)((frame * 2654435761u + axis * 40503u) >> 16);
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    static mpuBlock block;
+    static mpuBlock copy;
+    static float data[6][MPU9250_BLOCK_LEN];
+    const float accelBias[3] = {0.05f, -0.02f, 0.1f};
+    mpu9250Calibration cal;
+    I2C_Handle handle = NULL;
+    uint32_t repeats = 1000000;
+    uint32_t r = 0;
+    uint16_t frame = 0;
+    uint16_t read = 0;
+    uint16_t i = 0;
+    int errors = 0;
+    double start = 0;
+
+    if (argc > 2 && strcmp(argv[1], "-r") == 0) {
+        repeats = strtoul(argv[2], NULL, 10);
+    }
+    memset(&cal, 0, sizeof(cal));
+    memcpy(cal.accelBias, accelBias, sizeof(cal.accelBias));
+    mpu9250_setup_fast(&handle, &cal);
+    mpu9250_fifo_start(&handle);
+    for (; frame < FRAMES; frame++) {
+        int16_t sample[6];
+        uint8_t axis = 0;
+        for (; axis < 6; axis++) {
+            sample[axis] = sampleValue(frame, axis);
+        }
+        pushFrame(sample);
+    }
+
+    while (mpu9250_read_block(&handle, &block) > 0) {
+        uint8_t axis = 0;
+        copy = block;
+        mpu9250_convert_block(&block, data);
+        mpu9250_remove_bias(&copy);
+        for (; axis < 6; axis++) {
+            for (i = 0; i < block.count; i++) {
+                int16_t raw = sampleValue(read + i, axis);
+                double expected = axis < 3 ? raw * ACCEL_RES - accelBias[axis] : raw * GYRO_RES;
+                int32_t counts = axis < 3 ? (int32_t)raw - (int16_t)(accelBias[axis] / ACCEL_RES) : raw;
+                counts = counts > INT16_MAX ? INT16_MAX : counts < INT16_MIN ? INT16_MIN : counts;
+                if (block.raw[axis][i] != raw || fabs(data[axis][i] - expected) > 1e-5 * fmax(1, fabs(expected)) ||
+                    copy.raw[axis][i] != counts) {
+                    if (errors++ < 10) {
+                        printf("sample %u axis %u: raw %d/%d, converted %f/%f, bias removed %d/%d\n",
+                               read + i, axis, block.raw[axis][i], raw, data[axis][i], expected,
+                               copy.raw[axis][i], counts);
+                    }
+                }
+            }
+        }
+        printf("block of %u samples\n", block.count);
+        read += block.count;
+    }
+    if (read != FRAMES) {
+        printf("read %u samples, expected %u\n", read, FRAMES);
+        errors++;
+    }
+
+    block.count = MPU9250_BLOCK_LEN;
+    start = now();
+    for (; r < repeats; r++) {
+        mpu9250_convert_block(&block, data);
+        // Keep the compiler from dropping the repeats
+        __asm__ volatile("" : : "r"(data) : "memory");
+    }
+    printf("conversion: %.2f ns/sample\n", (now() - start) * 1e9 / ((double)repeats * MPU9250_BLOCK_LEN));
+
+    printf(errors ? "FAIL\n" : "PASS\n");
+    return errors != 0;
+}
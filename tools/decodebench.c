@@ -0,0 +1,163 @@
+/*
+ * decodebench.c
+ *
+ *  PC side benchmark of the morse tree decoder against the linear table
+ *  scan it replaced.
+ *
+ *  Build and run on the PC, not part of the SensorTag project:
+ *    gcc -O2 -I.. -Ihost -o decodebench decodebench.c ../coders.c ../message.c ../msgpool.c
+ *    ./decodebench [-r repeats] [-s seed]
+ *
+ *  A random text of letters, digits and spaces is encoded once, then
+ *  decoded repeats times by both decoders. The outputs must be equal,
+ *  the exit status is 1 if they differ. Reported is the time per
+ *  decoded symbol for each decoder.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "message.h"
+#include "coders.h"
+
+#define TEXT_LEN 80
+#define SCAN_TABLE_LEN 36
+
+// Tables of the linear scan decoder
+static const char ALPHABET[SCAN_TABLE_LEN] = {'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I',
+                         'J', 'K', 'L', 'M', 'N', 'O', 'P', 'Q', 'R',
+                         'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', '1',
+                         '2', '3', '4', '5', '6', '7', '8', '9', '0'};
+
+static const char *MORSE_TABLE[SCAN_TABLE_LEN] = {".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..",
+                             ".---", "-.-", ".-..", "--", "-.", "---", ".--.", "--.-", ".-.",
+                             "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--..", ".----",
+                             "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----.", "-----"};
+
+static uint8_t scanIndex(const char *symbol, uint8_t len) {
+    /*
+     * Finds the table index of a morse symbol of len elements
+     * @return index or SCAN_TABLE_LEN if the symbol is unknown
+     */
+    uint8_t i = 0;
+    for (; i < SCAN_TABLE_LEN; i++) {
+        if (MORSE_TABLE[i][len] == '\0' && strncmp(MORSE_TABLE[i], symbol, len) == 0) {
+            return i;
+        }
+    }
+    return SCAN_TABLE_LEN;
+}
+
+static void scanDecode(const char *chr, msg *message, uint16_t len) {
+    /*
+     * Linear scan decoder of morse characters, same output as decode
+     */
+    char tmp[MAX_SYMBOL_LEN + 1];
+    uint8_t i = 0;
+    uint8_t j = 0;
+    uint8_t space_count = 0;
+    uint16_t k = 0;
+
+    for (; chr[k] != '\0' && k < len; k++) {
+        if (chr[k] == ' ') {
+            space_count++;
+            if (space_count == 1 && i > 0) {
+                j = i <= MAX_SYMBOL_LEN ? scanIndex(tmp, i) : SCAN_TABLE_LEN;
+                msgAppend(message, j < SCAN_TABLE_LEN ? ALPHABET[j] : '?');
+                i = 0;
+            } if (space_count == 3) {
+                break;
+            }
+        } else {
+            if (space_count == 2) {
+                msgAppend(message, ' ');
+            }
+            space_count = 0;
+            if (i < MAX_SYMBOL_LEN) {
+                tmp[i] = chr[k];
+            }
+            i++;
+        }
+    }
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    char text[TEXT_LEN + 1];
+    uint32_t repeats = 100000;
+    uint32_t symbols = 0;
+    uint32_t r = 0;
+    uint16_t i = 0;
+    double start = 0;
+    double treeTime = 0;
+    double scanTime = 0;
+    int opt = 1;
+    morseMsg morse;
+    msg chars;
+    msg treeOut;
+    msg scanOut;
+
+    srand(1);
+    for (; opt + 1 < argc; opt += 2) {
+        if (strcmp(argv[opt], "-r") == 0) {
+            repeats = strtoul(argv[opt + 1], NULL, 10);
+        } else if (strcmp(argv[opt], "-s") == 0) {
+            srand(strtoul(argv[opt + 1], NULL, 10));
+        }
+    }
+
+    for (; i < TEXT_LEN; i++) {
+        if (i > 0 && i < TEXT_LEN - 1 && text[i - 1] != ' ' && rand() % 6 == 0) {
+            text[i] = ' ';
+        } else {
+            text[i] = ALPHABET[rand() % SCAN_TABLE_LEN];
+        }
+        symbols += text[i] != ' ';
+    }
+    text[TEXT_LEN] = '\0';
+
+    morseMsgInit(&morse);
+    msgInit(&chars);
+    msgInit(&treeOut);
+    msgInit(&scanOut);
+    encode(text, &morse, TEXT_LEN);
+    morseMsgUnpack(&morse, &chars);
+    msgString(&chars);
+
+    start = now();
+    for (r = 0; r < repeats; r++) {
+        msgClear(&treeOut);
+        decode(&morse, &treeOut);
+    }
+    treeTime = now() - start;
+
+    start = now();
+    for (r = 0; r < repeats; r++) {
+        msgClear(&scanOut);
+        scanDecode(chars.data, &scanOut, chars.count);
+    }
+    scanTime = now() - start;
+
+    printf("text:   %s\n", text);
+    printf("tree:   %s\n", msgString(&treeOut));
+    printf("scan:   %s\n", msgString(&scanOut));
+    printf("%u symbols x %u\n", symbols, repeats);
+    printf("tree decoder: %.1f ns/symbol\n", treeTime * 1e9 / ((double)symbols * repeats));
+    printf("scan decoder: %.1f ns/symbol\n", scanTime * 1e9 / ((double)symbols * repeats));
+
+    if (strcmp(treeOut.data, text) != 0 || strcmp(scanOut.data, text) != 0) {
+        printf("FAIL: decoded text differs\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
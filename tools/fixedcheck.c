@@ -0,0 +1,358 @@
+/*
+ * fixedcheck.c
+ *
+ *  PC side check that the integer motion pipeline makes the same
+ *  decisions as the same pipeline in floating point physical units.
+ *
+ *  Build and run on the PC, not part of the SensorTag project:
+ *    gcc -O2 -I.. -o fixedcheck fixedcheck.c ../motion.c ../boxcar.c ../extrema.c ../gesture.c ../fusion.c -lm
+ *    ./fixedcheck [-b mg] trace.csv...
+ *
+ *  Traces are CSV files as read by tools/replay.c, replay -p turns a
+ *  binary capture into one. The values are taken as raw register counts
+ *  and an accelerometer bias of -b mg (default 0) is removed from them:
+ *  on the fixed side with the saturating subtraction of
+ *  mpu9250_remove_bias, on the float side as g after conversion. Both
+ *  sides then fuse the orientation, average, track the window extrema
+ *  and check the moves of motion.c. The float side runs the Mahony
+ *  filter of fusion.c in double precision and uses the thresholds in
+ *  degrees and deg/s.
+ *
+ *  Reported are the symbols of both sides and, at the first sample
+ *  where they differ, how close the float window was to a threshold in
+ *  register counts. The exit status is 1 if any trace differs.
+ *  tools/blockcheck.c checks the bias subtraction of the driver itself
+ *  at saturation.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "motion.h"
+
+#define MAX_SYMBOLS 256
+#define ACCEL_RES (8.0 / 32768.0)   // g per count, AFS_8G
+#define GYRO_RES (250.0 / 32768.0)  // deg/s per count, GFS_250DPS
+
+#define ANGLE_RES (180.0 / 32768.0) // degrees per binary angle count
+#define SAMPLE_DT (MOTION_SAMPLE_PERIOD / 1000.0)
+#define KP 0.5 // Proportional gain (rad/s) of fusion.c
+
+// Moves of motion.c in physical units
+#define TURN_ANGLE 45.0
+#define TURN_LEVEL 15.0
+#define TURN_PITCH 30.0
+#define SHAKE_GYRO 200.0
+#define SHAKE_SPAN 150
+
+typedef struct floatPipeline {
+    double q[4];
+    uint8_t started;
+    double window[AVG_WIN_SIZE][MOTION_AXES];
+    uint8_t filled;
+    uint8_t index;
+    uint8_t phase;
+    double avg[NUM_SAMPLES][MOTION_TRACKED];
+    uint32_t times[NUM_SAMPLES];
+    uint8_t dataIndex;
+    uint8_t dataReadyNum;
+    double margin; // Closest distance of a term to its threshold in counts at the last check
+} floatPipeline;
+
+typedef struct symbolList {
+    uint16_t count;
+    char symbol[MAX_SYMBOLS];
+    uint32_t time[MAX_SYMBOLS];
+} symbolList;
+
+static int16_t removeBias(int16_t raw, int16_t bias) {
+    // Same arithmetic as mpu9250_remove_bias
+    int32_t value = (int32_t)raw - bias;
+    if (value > INT16_MAX) {
+        value = INT16_MAX;
+    } else if (value < INT16_MIN) {
+        value = INT16_MIN;
+    }
+    return (int16_t)value;
+}
+
+static void closer(floatPipeline *p, double value, double threshold, double res) {
+    double margin = fabs(value - threshold) / res;
+    if (margin < p->margin) {
+        p->margin = margin;
+    }
+}
+
+static char floatCheck(floatPipeline *p) {
+    /*
+     * Float version of getMaxMin, gestureMatch and the GESTURES table
+     */
+    double max[MOTION_TRACKED];
+    double min[MOTION_TRACKED];
+    uint32_t maxTime[MOTION_TRACKED];
+    uint32_t minTime[MOTION_TRACKED];
+    uint8_t axis = 0;
+    uint8_t i = 0;
+    for (; axis < MOTION_TRACKED; axis++) {
+        // Oldest first so ties keep the earliest sample like the extrema deques
+        for (i = 0; i < NUM_SAMPLES; i++) {
+            uint8_t slot = (p->dataIndex + i) % NUM_SAMPLES;
+            double value = p->avg[slot][axis];
+            if (i == 0 || value > max[axis]) {
+                max[axis] = value;
+                maxTime[axis] = p->times[slot];
+            }
+            if (i == 0 || value < min[axis]) {
+                min[axis] = value;
+                minTime[axis] = p->times[slot];
+            }
+        }
+    }
+    p->margin = 1e9;
+    closer(p, min[6], TURN_LEVEL, ANGLE_RES);
+    closer(p, max[6], TURN_ANGLE, ANGLE_RES);
+    closer(p, max[6], -TURN_LEVEL, ANGLE_RES);
+    closer(p, min[6], -TURN_ANGLE, ANGLE_RES);
+    closer(p, max[7], TURN_PITCH, ANGLE_RES);
+    closer(p, min[7], -TURN_PITCH, ANGLE_RES);
+    closer(p, max[5], SHAKE_GYRO, GYRO_RES);
+    closer(p, min[5], -SHAKE_GYRO, GYRO_RES);
+
+    if (min[6] < TURN_LEVEL && max[6] > TURN_ANGLE && max[7] < TURN_PITCH && min[7] > -TURN_PITCH &&
+        minTime[6] < maxTime[6]) {
+        return '.';
+    }
+    if (max[6] > -TURN_LEVEL && min[6] < -TURN_ANGLE && max[7] < TURN_PITCH && min[7] > -TURN_PITCH &&
+        maxTime[6] < minTime[6]) {
+        return '-';
+    }
+    if (max[5] > SHAKE_GYRO && min[5] < -SHAKE_GYRO) {
+        uint32_t span = maxTime[5] > minTime[5] ? maxTime[5] - minTime[5] : minTime[5] - maxTime[5];
+        if (span <= SHAKE_SPAN) {
+            return ' ';
+        }
+    }
+    return 0;
+}
+
+static void floatFusion(floatPipeline *p, const double *sample) {
+    /*
+     * Mahony filter of fusion.c in double precision, sample in g and deg/s
+     */
+    double *q = p->q;
+    double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    double wx = sample[3] * M_PI / 180.0;
+    double wy = sample[4] * M_PI / 180.0;
+    double wz = sample[5] * M_PI / 180.0;
+    double norm = sqrt(sample[0] * sample[0] + sample[1] * sample[1] + sample[2] * sample[2]);
+    if (norm > 0) {
+        double ax = sample[0] / norm, ay = sample[1] / norm, az = sample[2] / norm;
+        if (!p->started) {
+            double s = sqrt((1 + az) / 2);
+            p->started = 1;
+            if (s >= 1024.0 / 32768.0) {
+                q[0] = s;
+                q[1] = ay / (2 * s);
+                q[2] = -ax / (2 * s);
+                q[3] = 0;
+            }
+            return;
+        }
+        double vx = 2 * (q1 * q3 - q0 * q2);
+        double vy = 2 * (q0 * q1 + q2 * q3);
+        double vz = q0 * q0 - q1 * q1 - q2 * q2 + q3 * q3;
+        wx += KP * (ay * vz - az * vy);
+        wy += KP * (az * vx - ax * vz);
+        wz += KP * (ax * vy - ay * vx);
+    }
+    wx *= SAMPLE_DT / 2;
+    wy *= SAMPLE_DT / 2;
+    wz *= SAMPLE_DT / 2;
+    q[0] = q0 - q1 * wx - q2 * wy - q3 * wz;
+    q[1] = q1 + q0 * wx + q2 * wz - q3 * wy;
+    q[2] = q2 + q0 * wy - q1 * wz + q3 * wx;
+    q[3] = q3 + q0 * wz + q1 * wy - q2 * wx;
+    norm = sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    q[0] /= norm;
+    q[1] /= norm;
+    q[2] /= norm;
+    q[3] /= norm;
+}
+
+static char floatPut(floatPipeline *p, const double *sample, uint32_t time) {
+    /*
+     * Float version of motionPut
+     */
+    const double *q = p->q;
+    uint8_t axis = 0;
+    char symbol = 0;
+    floatFusion(p, sample);
+    memcpy(p->window[p->index], sample, sizeof(p->window[0]));
+    p->index = (p->index + 1) % AVG_WIN_SIZE;
+    if (p->filled < AVG_WIN_SIZE) {
+        p->filled++;
+    }
+    p->phase++;
+    if (p->filled < AVG_WIN_SIZE || p->phase < AVG_STEP) {
+        return 0;
+    }
+    p->phase = 0;
+    for (; axis < MOTION_AXES; axis++) {
+        double sum = 0;
+        uint8_t i = 0;
+        for (; i < AVG_WIN_SIZE; i++) {
+            sum += p->window[i][axis];
+        }
+        p->avg[p->dataIndex][axis] = sum / AVG_WIN_SIZE;
+    }
+    p->avg[p->dataIndex][6] = atan2(q[0] * q[1] + q[2] * q[3], 0.5 - q[1] * q[1] - q[2] * q[2]) * 180.0 / M_PI;
+    p->avg[p->dataIndex][7] = asin(fmax(-1, fmin(1, 2 * (q[0] * q[2] - q[3] * q[1])))) * 180.0 / M_PI;
+    p->times[p->dataIndex] = time;
+    p->dataIndex = (p->dataIndex + 1) % NUM_SAMPLES;
+    if (p->dataReadyNum < NUM_SAMPLES) {
+        p->dataReadyNum++;
+    }
+    if (p->dataReadyNum >= NUM_SAMPLES) {
+        symbol = floatCheck(p);
+        if (symbol != 0) {
+            p->dataReadyNum = 0;
+        }
+    }
+    return symbol;
+}
+
+static void addSymbol(symbolList *list, char symbol, uint32_t time) {
+    if (list->count < MAX_SYMBOLS) {
+        list->symbol[list->count] = symbol;
+        list->time[list->count] = time;
+        list->count++;
+    }
+}
+
+static void printSymbols(const char *name, const symbolList *list) {
+    uint16_t i = 0;
+    printf("  %s: \"", name);
+    for (; i < list->count; i++) {
+        putchar(list->symbol[i]);
+    }
+    printf("\"\n");
+}
+
+static int compare(const char *name, int16_t (*samples)[MOTION_AXES], uint32_t *times,
+                   uint32_t count, double biasMg) {
+    /*
+     * Runs samples through both pipelines
+     * @return 1 if the symbols differ, 0 otherwise
+     */
+    static floatPipeline p;
+    symbolList fixedSymbols;
+    symbolList floatSymbols;
+    int16_t biasCounts = (int16_t)(biasMg / 1000.0 / ACCEL_RES);
+    uint8_t diverged = 0;
+    uint32_t i = 0;
+
+    memset(&p, 0, sizeof(p));
+    p.q[0] = 1;
+    memset(&fixedSymbols, 0, sizeof(fixedSymbols));
+    memset(&floatSymbols, 0, sizeof(floatSymbols));
+    printf("%s: %u samples, bias %.0f mg\n", name, count, biasMg);
+    motionInit();
+    for (; i < count; i++) {
+        int16_t fixed[MOTION_AXES];
+        double value[MOTION_AXES];
+        uint8_t axis = 0;
+        for (; axis < MOTION_AXES; axis++) {
+            if (axis < 3) {
+                fixed[axis] = removeBias(samples[i][axis], biasCounts);
+                value[axis] = samples[i][axis] * ACCEL_RES - biasMg / 1000.0;
+            } else {
+                fixed[axis] = samples[i][axis];
+                value[axis] = samples[i][axis] * GYRO_RES;
+            }
+        }
+        char a = motionPut(fixed, times[i]);
+        char b = floatPut(&p, value, times[i]);
+        if (a != 0) {
+            addSymbol(&fixedSymbols, a, times[i]);
+        }
+        if (b != 0) {
+            addSymbol(&floatSymbols, b, times[i]);
+        }
+        if (a != b && !diverged) {
+            printf("  first difference at %u ms: fixed '%c', float '%c', float window %.2f counts from a threshold\n",
+                   times[i], a ? a : '0', b ? b : '0', p.margin);
+            diverged = 1;
+        }
+    }
+
+    printSymbols("fixed", &fixedSymbols);
+    printSymbols("float", &floatSymbols);
+    if (diverged) {
+        printf("  DIFFERENT\n");
+        return 1;
+    }
+    printf("  same\n");
+    return 0;
+}
+
+static int loadCsv(const char *path, int16_t (**samples)[MOTION_AXES], uint32_t **times, uint32_t *count) {
+    char line[256];
+    uint32_t size = 0;
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        perror(path);
+        return 0;
+    }
+    *count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        long v[7];
+        if (sscanf(line, "%ld,%ld,%ld,%ld,%ld,%ld,%ld", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) < 7) {
+            continue; // Header or comment
+        }
+        if (*count == size) {
+            size = size ? size * 2 : 1024;
+            *samples = realloc(*samples, size * sizeof(**samples));
+            *times = realloc(*times, size * sizeof(**times));
+            if (*samples == NULL || *times == NULL) {
+                fprintf(stderr, "Out of memory\n");
+                exit(1);
+            }
+        }
+        (*times)[*count] = v[0];
+        uint8_t axis = 0;
+        for (; axis < MOTION_AXES; axis++) {
+            (*samples)[*count][axis] = v[axis + 1];
+        }
+        (*count)++;
+    }
+    fclose(file);
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    int16_t (*samples)[MOTION_AXES] = NULL;
+    uint32_t *times = NULL;
+    uint32_t count = 0;
+    double biasMg = 0;
+    int failures = 0;
+    int opt = 1;
+
+    if (opt + 1 < argc && strcmp(argv[opt], "-b") == 0) {
+        biasMg = atof(argv[opt + 1]);
+        opt += 2;
+    }
+    for (; opt < argc; opt++) {
+        if (!loadCsv(argv[opt], &samples, &times, &count)) {
+            return 1;
+        }
+        failures += compare(argv[opt], samples, times, count, biasMg);
+    }
+    free(samples);
+    free(times);
+    printf(failures ? "FAIL\n" : "PASS\n");
+    return failures != 0;
+}
@@ -0,0 +1,13 @@
+/*
+ * Board.h
+ *
+ *  PC stand-in for the SensorTag board file, only the MPU9250 address.
+ *
+ */
+
+#ifndef HOST_BOARD_H_
+#define HOST_BOARD_H_
+
+#define Board_MPU9250_ADDR (0x68)
+
+#endif /* HOST_BOARD_H_ */
@@ -0,0 +1,29 @@
+/*
+ * I2C.h
+ *
+ *  PC stand-in for ti.drivers.I2C. The tool that builds a sensor driver
+ *  provides I2C_transfer and answers for the sensor.
+ *
+ */
+
+#ifndef HOST_I2C_H_
+#define HOST_I2C_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct I2C_Config *I2C_Handle;
+
+typedef struct I2C_Transaction {
+    void *writeBuf;
+    size_t writeCount;
+    void *readBuf;
+    size_t readCount;
+    uint_least8_t slaveAddress;
+    void *arg;
+} I2C_Transaction;
+
+bool I2C_transfer(I2C_Handle handle, I2C_Transaction *transaction);
+
+#endif /* HOST_I2C_H_ */
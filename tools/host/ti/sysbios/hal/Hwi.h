@@ -0,0 +1,17 @@
+/*
+ * Hwi.h
+ *
+ *  PC stand-in for ti.sysbios.hal.Hwi. The tools are single threaded
+ *  where these are used, so disabling interrupts does nothing.
+ *
+ */
+
+#ifndef HOST_HWI_H_
+#define HOST_HWI_H_
+
+#include <xdc/std.h>
+
+#define Hwi_disable() ((UInt)0)
+#define Hwi_restore(key) ((void)(key))
+
+#endif /* HOST_HWI_H_ */
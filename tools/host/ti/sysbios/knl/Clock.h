@@ -0,0 +1,15 @@
+/*
+ * Clock.h
+ *
+ *  PC stand-in for ti.sysbios.knl.Clock, only the tick period.
+ *
+ */
+
+#ifndef HOST_CLOCK_H_
+#define HOST_CLOCK_H_
+
+#include <xdc/std.h>
+
+#define Clock_tickPeriod 10 // us, as in the SensorTag configuration
+
+#endif /* HOST_CLOCK_H_ */
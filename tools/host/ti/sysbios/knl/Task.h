@@ -0,0 +1,15 @@
+/*
+ * Task.h
+ *
+ *  PC stand-in for ti.sysbios.knl.Task, sleeps return at once.
+ *
+ */
+
+#ifndef HOST_TASK_H_
+#define HOST_TASK_H_
+
+#include <xdc/std.h>
+
+#define Task_sleep(ticks) ((void)(ticks))
+
+#endif /* HOST_TASK_H_ */
@@ -0,0 +1,18 @@
+/*
+ * System.h
+ *
+ *  PC stand-in for xdc.runtime.System, aborts print to stderr.
+ *
+ */
+
+#ifndef HOST_XDC_SYSTEM_H_
+#define HOST_XDC_SYSTEM_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define System_abort(str) (fprintf(stderr, "%s\n", (str)), abort())
+#define System_printf printf
+#define System_flush() fflush(stdout)
+
+#endif /* HOST_XDC_SYSTEM_H_ */
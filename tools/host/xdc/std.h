@@ -0,0 +1,17 @@
+/*
+ * std.h
+ *
+ *  PC stand-in for the XDC base types used by the modules built in tools/.
+ *
+ */
+
+#ifndef HOST_XDC_STD_H_
+#define HOST_XDC_STD_H_
+
+#include <stdint.h>
+
+typedef unsigned int UInt;
+typedef uintptr_t UArg;
+typedef void Void;
+
+#endif /* HOST_XDC_STD_H_ */
@@ -0,0 +1,167 @@
+/*
+ * linkbench.c
+ *
+ *  PC side throughput benchmark of the framed UART link.
+ *
+ *  Build and run on the PC, not part of the SensorTag project:
+ *    gcc -O2 -pthread -I.. -o linkbench linkbench.c serial.c ../link.c
+ *    ./linkbench [-n frames] [-l payload] [-b baud] [device]
+ *
+ *  Without a device the frames go through a pseudo terminal pair, which
+ *  measures the encoder and parser with the tty layer but no line rate.
+ *  With a device, e.g. a USB serial adapter with RX wired to TX, they go
+ *  through the real line at baud. A writer thread encodes sample frames
+ *  with a running counter in the payload, the reader parses them and
+ *  checks that every frame arrives once, in order and with a valid crc.
+ *  Reported are frames/s, payload bytes/s and the share of the line
+ *  rate, at 10 bits per byte, used for payload. The exit status is 1 if
+ *  frames were lost or corrupted.
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "link.h"
+#include "serial.h"
+
+#define READ_TIMEOUT 20 // Reads give up after 2 s without data so lost frames do not hang the test
+
+typedef struct benchRun {
+    int fd;
+    uint32_t frames;
+    uint8_t length;
+} benchRun;
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *writer(void *arg) {
+    benchRun *run = (benchRun *)arg;
+    uint8_t payload[LINK_MAX_PAYLOAD];
+    uint8_t frame[LINK_MAX_FRAME];
+    uint32_t i = 0;
+    memset(payload, 0x55, sizeof(payload));
+    for (; i < run->frames; i++) {
+        memcpy(payload, &i, sizeof(i));
+        uint8_t len = linkEncode(LINK_SAMPLES, payload, run->length, frame);
+        uint8_t sent = 0;
+        while (sent < len) {
+            ssize_t n = write(run->fd, frame + sent, len - sent);
+            if (n < 0) {
+                perror("write");
+                return NULL;
+            }
+            sent += n;
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv) {
+    benchRun run = {-1, 100000, LINK_MAX_PAYLOAD};
+    uint32_t baud = 0;
+    uint32_t received = 0;
+    uint32_t errors = 0;
+    uint32_t expected = 0;
+    uint8_t buffer[4096];
+    int readFd = -1;
+    int opt = 1;
+    double start = 0;
+    double elapsed = 0;
+    pthread_t thread;
+    linkParser parser;
+
+    for (; opt < argc - 1 && argv[opt][0] == '-'; opt += 2) {
+        if (strcmp(argv[opt], "-n") == 0) {
+            run.frames = strtoul(argv[opt + 1], NULL, 10);
+        } else if (strcmp(argv[opt], "-l") == 0) {
+            run.length = strtoul(argv[opt + 1], NULL, 10);
+        } else if (strcmp(argv[opt], "-b") == 0) {
+            baud = strtoul(argv[opt + 1], NULL, 10);
+        }
+    }
+    if (run.length < sizeof(uint32_t) || run.length > LINK_MAX_PAYLOAD) {
+        printf("payload must be %u to %u bytes\n", (unsigned)sizeof(uint32_t), LINK_MAX_PAYLOAD);
+        return 1;
+    }
+    if (opt < argc) {
+        // Loopback wire, the same port writes and reads
+        if (baud == 0 || serialBaud(baud) == 0) {
+            printf("a supported baud rate is needed with a device\n");
+            return 1;
+        }
+        run.fd = serialOpen(argv[opt], baud, READ_TIMEOUT);
+        readFd = run.fd;
+        if (run.fd < 0) {
+            return 1;
+        }
+    } else {
+        run.fd = posix_openpt(O_RDWR | O_NOCTTY);
+        if (run.fd < 0 || grantpt(run.fd) != 0 || unlockpt(run.fd) != 0) {
+            perror("posix_openpt");
+            return 1;
+        }
+        readFd = open(ptsname(run.fd), O_RDWR | O_NOCTTY);
+        if (readFd < 0 || serialRaw(readFd, 0, READ_TIMEOUT) != 0) {
+            perror("ptsname");
+            return 1;
+        }
+    }
+
+    linkParserInit(&parser);
+    start = now();
+    if (pthread_create(&thread, NULL, writer, &run) != 0) {
+        printf("thread creation failed\n");
+        return 1;
+    }
+    while (expected < run.frames) {
+        ssize_t n = read(readFd, buffer, sizeof(buffer));
+        ssize_t i = 0;
+        if (n <= 0) {
+            printf("no data for 2 s\n");
+            break;
+        }
+        for (; i < n; i++) {
+            uint8_t result = linkParse(&parser, buffer[i]);
+            if (result == LINK_PARSE_DONE) {
+                uint32_t counter;
+                memcpy(&counter, parser.payload, sizeof(counter));
+                if (counter != expected || parser.length != run.length) {
+                    errors++;
+                }
+                expected = counter + 1;
+                received++;
+            } else if (result == LINK_PARSE_ERROR) {
+                errors++;
+            }
+        }
+    }
+    elapsed = now() - start;
+    pthread_join(thread, NULL);
+
+    printf("%u/%u frames of %u bytes in %.3f s, %u errors\n",
+           received, run.frames, run.length, elapsed, errors);
+    printf("%.0f frames/s, %.0f payload bytes/s\n",
+           received / elapsed, (double)received * run.length / elapsed);
+    if (baud != 0) {
+        printf("payload uses %.1f %% of %u baud\n",
+               100.0 * received * run.length * 10 / elapsed / baud, baud);
+    }
+    if (received != run.frames || errors != 0) {
+        printf("FAIL\n");
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * linkdecode.c
+ *
+ *  PC side decoder of the framed UART link.
+ *
+ *  Build and run on the PC, not part of the SensorTag project:
+ *    gcc -O2 -I.. -o linkdecode linkdecode.c serial.c ../link.c
+ *    ./linkdecode [-b baud] [-m text|binary] [device]
+ *
+ *  Reads the device (e.g. /dev/ttyACM0) or stdin, so a capture file can
+ *  be decoded too, and prints one line per frame. Bytes outside frames
+ *  are printed as text. -m sends LINK_CMD_SET_MODE to the device first,
+ *  preceded by a newline so the device accepts the frame in text mode.
+ *  The device answers at the new settings with an ack frame.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "link.h"
+#include "serial.h"
+
+static void printFrame(const linkParser *frame) {
+    uint8_t i = 0;
+    if (frame->type == LINK_SYMBOLS) {
+        printf("[symbols %u] ", frame->length);
+        for (; i < frame->length; i++) {
+            putchar(frame->payload[i]);
+        }
+        putchar('\n');
+    } else if (frame->type == LINK_SAMPLES) {
+        // uint32_t time followed by six int16_t axes per sample
+        for (; i + 16 <= frame->length; i += 16) {
+            const uint8_t *p = frame->payload + i;
+            uint32_t time = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+            int16_t v[6];
+            uint8_t j = 0;
+            for (; j < 6; j++) {
+                v[j] = (int16_t)(p[4 + 2 * j] | (p[5 + 2 * j] << 8));
+            }
+            printf("[sample] %u,%d,%d,%d,%d,%d,%d\n", time, v[0], v[1], v[2], v[3], v[4], v[5]);
+        }
+    } else if (frame->type == LINK_COMMAND && frame->length > 0) {
+        if (frame->payload[0] == LINK_CMD_ACK && frame->length == 2) {
+            printf("[ack] command 0x%02X\n", frame->payload[1]);
+        } else if (frame->payload[0] == LINK_CMD_NAK && frame->length == 2) {
+            printf("[nak] command 0x%02X\n", frame->payload[1]);
+        } else {
+            printf("[command 0x%02X]", frame->payload[0]);
+            for (i = 1; i < frame->length; i++) {
+                printf(" %02X", frame->payload[i]);
+            }
+            putchar('\n');
+        }
+    } else {
+        printf("[type 0x%02X, %u bytes]\n", frame->type, frame->length);
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t baud = 9600;
+    int mode = -1;
+    int fd = 0;
+    int opt = 1;
+    uint8_t buffer[256];
+    uint32_t frames = 0;
+    uint32_t errors = 0;
+    linkParser parser;
+
+    for (; opt < argc - 1 && argv[opt][0] == '-'; opt += 2) {
+        if (strcmp(argv[opt], "-b") == 0) {
+            baud = strtoul(argv[opt + 1], NULL, 10);
+        } else if (strcmp(argv[opt], "-m") == 0) {
+            mode = strcmp(argv[opt + 1], "binary") == 0 ? LINK_MODE_BINARY : LINK_MODE_TEXT;
+        }
+    }
+    if (opt < argc) {
+        fd = serialOpen(argv[opt], baud, 0);
+        if (fd < 0) {
+            return 1;
+        }
+    }
+    if (mode >= 0 && fd != 0) {
+        uint8_t frame[LINK_MAX_FRAME + 1];
+        uint8_t cmd[2] = {LINK_CMD_SET_MODE, (uint8_t)mode};
+        frame[0] = '\n';
+        uint8_t len = linkEncode(LINK_COMMAND, cmd, sizeof(cmd), frame + 1) + 1;
+        if (write(fd, frame, len) != len) {
+            perror("write");
+        }
+    }
+
+    linkParserInit(&parser);
+    while (1) {
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        ssize_t i = 0;
+        if (n <= 0) {
+            break;
+        }
+        for (; i < n; i++) {
+            switch (linkParse(&parser, buffer[i])) {
+            case LINK_PARSE_IDLE:
+                if (buffer[i] != '\0') {
+                    putchar(buffer[i]);
+                }
+                break;
+            case LINK_PARSE_DONE:
+                printFrame(&parser);
+                frames++;
+                break;
+            case LINK_PARSE_ERROR:
+                printf("[bad frame]\n");
+                errors++;
+                break;
+            }
+        }
+        fflush(stdout);
+    }
+    fprintf(stderr, "%u frames, %u bad\n", frames, errors);
+    return 0;
+}
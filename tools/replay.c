@@ -0,0 +1,330 @@
+/*
+ * replay.c
+ *
+ *  PC side replay of recorded MPU9250 traces through the motion pipeline.
+ *
+ *  Build and run on the PC, not part of the SensorTag project:
+ *    gcc -O2 -I.. -o replay replay.c ../motion.c ../boxcar.c ../extrema.c ../gesture.c ../fusion.c ../link.c
+ *    ./replay [-r repeats] [-p] [-c] trace
+ *
+ *  A trace is either a capture of the binary UART link while recording
+ *  (LINK_CMD_RECORD, LINK_SAMPLES frames) or a CSV file with lines
+ *  time,ax,ay,az,gx,gy,gz[,label]. Values are register counts with
+ *  accelerometer bias removed. label marks the first sample of a move
+ *  with '.', '-' or '_' for space. -p prints the trace as CSV so a
+ *  capture can be labeled. -c checks the trace: the exit status is 1
+ *  unless the detected symbols equal the labels.
+ *
+ *  traces/moves.csv is a synthetic fixture with a left turn, a right
+ *  turn, a burst of vibration without tilt, a shake and a slower left
+ *  turn plus +-40 counts of noise. The gyro clips at full scale in the
+ *  turns like the sensor does:
+ *    ./replay -c traces/moves.csv
+ *
+ *  Reported are the detected symbols, accuracy against the labels as
+ *  1 - edit distance / labels, CPU time per sample for the pipeline and
+ *  for the orientation filter alone, and the latency from a labeled
+ *  move to its symbol. On the device a symbol additionally waits for
+ *  the FIFO watermark and the UART flush.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "motion.h"
+#include "fusion.h"
+#include "link.h"
+
+#define MAX_DETECTIONS 1024
+#define MAX_LATENCY 1000 // Max time (ms) from a label to its symbol
+
+typedef struct traceSample {
+    uint32_t time;
+    int16_t value[MOTION_AXES];
+    char label;
+} traceSample;
+
+typedef struct detection {
+    uint32_t time;
+    char symbol;
+} detection;
+
+traceSample *trace = NULL;
+uint32_t traceLen = 0;
+uint32_t traceSize = 0;
+detection detections[MAX_DETECTIONS];
+uint16_t detectionCount = 0;
+
+traceSample *addSample() {
+    if (traceLen == traceSize) {
+        traceSize = traceSize ? traceSize * 2 : 1024;
+        trace = realloc(trace, traceSize * sizeof(traceSample));
+        if (trace == NULL) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+    }
+    memset(&trace[traceLen], 0, sizeof(traceSample));
+    return &trace[traceLen++];
+}
+
+char labelSymbol(char label) {
+    return label == '_' ? ' ' : label;
+}
+
+void loadCsv(FILE *file) {
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+        long v[7];
+        char label[4] = "";
+        int n = sscanf(line, "%ld,%ld,%ld,%ld,%ld,%ld,%ld,%3s",
+                       &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], label);
+        if (n < 7) {
+            continue; // Header or comment
+        }
+        traceSample *sample = addSample();
+        sample->time = v[0];
+        uint8_t axis = 0;
+        for (; axis < MOTION_AXES; axis++) {
+            sample->value[axis] = v[axis + 1];
+        }
+        if (n == 8) {
+            sample->label = labelSymbol(label[0]);
+        }
+    }
+}
+
+void loadCapture(FILE *file) {
+    linkParser parser;
+    int byte;
+    linkParserInit(&parser);
+    while ((byte = fgetc(file)) != EOF) {
+        if (linkParse(&parser, byte) != LINK_PARSE_DONE || parser.type != LINK_SAMPLES) {
+            continue;
+        }
+        const uint8_t *p = parser.payload;
+        uint8_t i = 0;
+        for (; i + 16 <= parser.length; i += 16, p += 16) {
+            traceSample *sample = addSample();
+            sample->time = p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+            uint8_t axis = 0;
+            for (; axis < MOTION_AXES; axis++) {
+                sample->value[axis] = (int16_t)(p[4 + 2 * axis] | (p[5 + 2 * axis] << 8));
+            }
+        }
+    }
+}
+
+double replay(uint32_t repeats) {
+    /*
+     * Runs the trace through the pipeline, detections are kept from the first run
+     * @return CPU time per sample in ns
+     */
+    struct timespec start, end;
+    uint32_t r = 0;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+    for (; r < repeats; r++) {
+        motionInit();
+        uint32_t i = 0;
+        for (; i < traceLen; i++) {
+            char symbol = motionPut(trace[i].value, trace[i].time);
+            if (symbol != 0 && r == 0 && detectionCount < MAX_DETECTIONS) {
+                detections[detectionCount].time = trace[i].time;
+                detections[detectionCount].symbol = symbol;
+                detectionCount++;
+            }
+        }
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    return ns / ((double)traceLen * repeats);
+}
+
+double replayFusion(uint32_t repeats) {
+    /*
+     * Runs the trace through the orientation filter only
+     * @return CPU time per sample in ns
+     */
+    struct timespec start, end;
+    fusion filter;
+    int16_t angles[3];
+    int32_t check = 0;
+    uint32_t r = 0;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start);
+    for (; r < repeats; r++) {
+        fusionReset(&filter);
+        uint32_t i = 0;
+        for (; i < traceLen; i++) {
+            fusionUpdate(&filter, trace[i].value);
+        }
+        fusionAngles(&filter, angles);
+        check += angles[FUSION_ROLL];
+    }
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &end);
+    if (check == 1) {
+        printf("\n"); // Keeps the loop from being optimized away
+    }
+    double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+    return ns / ((double)traceLen * repeats);
+}
+
+uint32_t editDistance(const char *a, uint32_t aLen, const char *b, uint32_t bLen) {
+    uint32_t *row = malloc((bLen + 1) * sizeof(uint32_t));
+    uint32_t i, j;
+    for (j = 0; j <= bLen; j++) {
+        row[j] = j;
+    }
+    for (i = 1; i <= aLen; i++) {
+        uint32_t diag = row[0];
+        row[0] = i;
+        for (j = 1; j <= bLen; j++) {
+            uint32_t up = row[j];
+            uint32_t best = diag + (a[i - 1] != b[j - 1]);
+            if (up + 1 < best) {
+                best = up + 1;
+            }
+            if (row[j - 1] + 1 < best) {
+                best = row[j - 1] + 1;
+            }
+            row[j] = best;
+            diag = up;
+        }
+    }
+    uint32_t distance = row[bLen];
+    free(row);
+    return distance;
+}
+
+uint8_t report(double nsPerSample, double nsFusion) {
+    /*
+     * Prints the results of the first replay
+     * @return 1 if the detected symbols equal the labels, 0 otherwise
+     */
+    char *expected = malloc(traceLen + 1);
+    char detected[MAX_DETECTIONS + 1];
+    uint32_t expectedLen = 0;
+    uint32_t i, j;
+    uint8_t *matched = calloc(detectionCount, 1);
+    uint32_t latencyCount = 0;
+    uint32_t latencySum = 0;
+    uint32_t latencyMax = 0;
+
+    for (i = 0; i < detectionCount; i++) {
+        detected[i] = detections[i].symbol;
+    }
+    detected[detectionCount] = '\0';
+
+    // Pair each label with the first unmatched detection of the same symbol after it
+    for (i = 0; i < traceLen; i++) {
+        if (trace[i].label == 0) {
+            continue;
+        }
+        expected[expectedLen++] = trace[i].label;
+        for (j = 0; j < detectionCount; j++) {
+            uint32_t latency = detections[j].time - trace[i].time;
+            if (!matched[j] && detections[j].symbol == trace[i].label &&
+                detections[j].time >= trace[i].time && latency <= MAX_LATENCY) {
+                matched[j] = 1;
+                latencyCount++;
+                latencySum += latency;
+                if (latency > latencyMax) {
+                    latencyMax = latency;
+                }
+                break;
+            }
+        }
+    }
+    expected[expectedLen] = '\0';
+
+    double duration = traceLen > 1 ? (trace[traceLen - 1].time - trace[0].time) / 1000.0 : 0;
+    printf("samples:   %u (%.1f s)\n", traceLen, duration);
+    printf("detected:  \"%s\"\n", detected);
+    if (expectedLen > 0) {
+        uint32_t distance = editDistance(expected, expectedLen, detected, detectionCount);
+        double accuracy = distance >= expectedLen ? 0 : 1.0 - (double)distance / expectedLen;
+        printf("expected:  \"%s\"\n", expected);
+        printf("accuracy:  %.1f %% (edit distance %u)\n", accuracy * 100, distance);
+        if (latencyCount > 0) {
+            printf("latency:   mean %u ms, max %u ms (%u moves)\n",
+                   latencySum / latencyCount, latencyMax, latencyCount);
+        }
+    }
+    printf("cpu:       %.1f ns per sample, %.0fx real time\n", nsPerSample,
+           MOTION_SAMPLE_PERIOD * 1e6 / nsPerSample);
+    printf("fusion:    %.1f ns per sample\n", nsFusion);
+    uint8_t same = strcmp(expected, detected) == 0;
+    free(expected);
+    free(matched);
+    return same;
+}
+
+void printTrace() {
+    uint32_t i = 0;
+    printf("time,ax,ay,az,gx,gy,gz,label\n");
+    for (; i < traceLen; i++) {
+        const traceSample *s = &trace[i];
+        printf("%u,%d,%d,%d,%d,%d,%d", s->time, s->value[0], s->value[1], s->value[2],
+               s->value[3], s->value[4], s->value[5]);
+        if (s->label != 0) {
+            printf(",%c", s->label == ' ' ? '_' : s->label);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t repeats = 100;
+    uint8_t print = 0;
+    uint8_t check = 0;
+    const char *path = NULL;
+    int i = 1;
+    for (; i < argc; i++) {
+        if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0) {
+            print = 1;
+        } else if (strcmp(argv[i], "-c") == 0) {
+            check = 1;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (path == NULL || repeats == 0) {
+        fprintf(stderr, "Usage: %s [-r repeats] [-p] [-c] trace.csv|capture.bin\n", argv[0]);
+        return 1;
+    }
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) {
+        perror(path);
+        return 1;
+    }
+    size_t len = strlen(path);
+    if (len > 4 && strcmp(path + len - 4, ".csv") == 0) {
+        loadCsv(file);
+    } else {
+        loadCapture(file);
+    }
+    fclose(file);
+
+    if (traceLen == 0) {
+        fprintf(stderr, "%s: no samples\n", path);
+        return 1;
+    }
+    if (print) {
+        printTrace();
+        return 0;
+    }
+    double nsPerSample = replay(repeats);
+    uint8_t same = report(nsPerSample, replayFusion(repeats));
+    free(trace);
+    if (check) {
+        printf(same ? "PASS\n" : "FAIL\n");
+        return !same;
+    }
+    return 0;
+}
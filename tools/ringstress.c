@@ -0,0 +1,136 @@
+/*
+ * ringstress.c
+ *
+ *  PC side stress test of the SPSC ring buffer with a producer and a
+ *  consumer thread on separate cores.
+ *
+ *  Build and run on the PC, not part of the SensorTag project:
+ *    gcc -O2 -pthread -DRINGBUF_FENCES -I.. -o ringstress ringstress.c ../ringbuf.c
+ *    ./ringstress [-n bytes] [-s ring size]
+ *
+ *  RINGBUF_FENCES makes ringbuf.c order its data and index accesses with
+ *  C11 fences, without it the test may fail on weakly ordered CPUs.
+ *
+ *  The first pass retries full puts like a task would, every byte of a
+ *  counting sequence must arrive in order. The second pass drops on full
+ *  like the UART callback, the consumer must see every byte the producer
+ *  got in and dropped must count the rest. The exit status is 1 on a
+ *  failure.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+
+#include "ringbuf.h"
+
+#define MAX_RING_SIZE 4096
+
+typedef struct stressRun {
+    ringBuf ring;
+    uint32_t count;      // Bytes the producer offers
+    uint8_t retry;       // Producer retries full puts instead of dropping
+    uint32_t accepted;   // Bytes the producer got into the ring
+    atomic_int done;     // Producer has finished
+} stressRun;
+
+static char storage[MAX_RING_SIZE];
+
+static void *producer(void *arg) {
+    stressRun *run = (stressRun *)arg;
+    uint32_t i = 0;
+    for (; i < run->count; i++) {
+        if (ringBufPut(&run->ring, (char)i)) {
+            run->accepted++;
+        } else if (run->retry) {
+            // Let the consumer run when both threads share a core
+            sched_yield();
+            i--;
+        }
+    }
+    atomic_store_explicit(&run->done, 1, memory_order_release);
+    return NULL;
+}
+
+static int consume(stressRun *run) {
+    /*
+     * Reads until the producer is done and the ring is empty
+     * @return number of errors found
+     */
+    uint32_t received = 0;
+    uint8_t expected = 0;
+    int errors = 0;
+    char chr;
+    while (1) {
+        if (ringBufGet(&run->ring, &chr)) {
+            if (run->retry && (uint8_t)chr != expected) {
+                if (errors++ < 10) {
+                    printf("byte %u: got %u, expected %u\n", received, (uint8_t)chr, expected);
+                }
+            }
+            expected = (uint8_t)chr + 1;
+            received++;
+        } else if (atomic_load_explicit(&run->done, memory_order_acquire) &&
+                   ringBufCount(&run->ring) == 0) {
+            break;
+        } else {
+            sched_yield();
+        }
+    }
+    if (received != run->accepted) {
+        printf("received %u bytes, producer put %u\n", received, run->accepted);
+        errors++;
+    }
+    // Retried puts are counted in dropped too, it is 16 bits wide and wraps
+    if (!run->retry && (uint16_t)(run->count - run->accepted) != run->ring.dropped) {
+        printf("dropped %u, expected %u\n", run->ring.dropped, run->count - run->accepted);
+        errors++;
+    }
+    printf("%s: %u bytes, %u received, %u dropped, %d errors\n",
+           run->retry ? "retry" : "drop", run->count, received, run->ring.dropped, errors);
+    return errors;
+}
+
+static int stress(uint32_t count, uint16_t size, uint8_t retry) {
+    stressRun run;
+    pthread_t thread;
+    memset(&run, 0, sizeof(run));
+    ringBufInit(&run.ring, storage, size);
+    run.count = count;
+    run.retry = retry;
+    atomic_init(&run.done, 0);
+    if (pthread_create(&thread, NULL, producer, &run) != 0) {
+        printf("thread creation failed\n");
+        return 1;
+    }
+    int errors = consume(&run);
+    pthread_join(thread, NULL);
+    return errors;
+}
+
+int main(int argc, char **argv) {
+    uint32_t count = 50000000;
+    uint16_t size = 256;
+    int errors = 0;
+    int opt = 1;
+    for (; opt + 1 < argc; opt += 2) {
+        if (strcmp(argv[opt], "-n") == 0) {
+            count = strtoul(argv[opt + 1], NULL, 10);
+        } else if (strcmp(argv[opt], "-s") == 0) {
+            size = strtoul(argv[opt + 1], NULL, 10);
+        }
+    }
+    if (size < 2 || size > MAX_RING_SIZE || (size & (size - 1)) != 0) {
+        printf("ring size must be a power of two up to %u\n", MAX_RING_SIZE);
+        return 1;
+    }
+    errors += stress(count, size, 1);
+    errors += stress(count, size, 0);
+    printf(errors ? "FAIL\n" : "PASS\n");
+    return errors != 0;
+}
@@ -0,0 +1,81 @@
+/*
+ * serial.c
+ *
+ *  PC side serial port setup shared by the link tools.
+ *
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+
+#include "serial.h"
+
+speed_t serialBaud(uint32_t baud) {
+    /*
+     * termios constant of a baud rate
+     * @return speed or 0 if the rate is not supported
+     */
+    switch (baud) {
+    case 1200: return B1200;
+    case 2400: return B2400;
+    case 4800: return B4800;
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    }
+    return 0;
+}
+
+int serialRaw(int fd, uint32_t baud, uint8_t timeout) {
+    /*
+     * Puts an open terminal into raw mode
+     * @param baud: line rate, 0 keeps the current one
+     * @param timeout: reads give up after timeout tenths of a second
+     * without data, 0 blocks until at least one byte arrives
+     * @return 0 on success, -1 on failure
+     */
+    struct termios tio;
+    if (tcgetattr(fd, &tio) != 0) {
+        return -1;
+    }
+    cfmakeraw(&tio);
+    if (baud != 0) {
+        cfsetispeed(&tio, serialBaud(baud));
+        cfsetospeed(&tio, serialBaud(baud));
+    }
+    tio.c_cc[VMIN] = timeout == 0;
+    tio.c_cc[VTIME] = timeout;
+    return tcsetattr(fd, TCSANOW, &tio);
+}
+
+int serialOpen(const char *path, uint32_t baud, uint8_t timeout) {
+    /*
+     * Opens path as a raw serial port at baud, see serialRaw for timeout
+     * A path that is not a terminal, e.g. a capture file, is opened as is
+     * @return file descriptor or -1
+     */
+    int fd = -1;
+    if (serialBaud(baud) == 0) {
+        fprintf(stderr, "unsupported baud rate %u\n", baud);
+        return -1;
+    }
+    fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd >= 0 && !isatty(fd)) {
+        return fd;
+    }
+    if (fd < 0 || serialRaw(fd, baud, timeout) != 0) {
+        perror(path);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return -1;
+    }
+    return fd;
+}
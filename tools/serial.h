@@ -0,0 +1,18 @@
+/*
+ * serial.h
+ *
+ *  PC side serial port setup shared by the link tools.
+ *
+ */
+
+#ifndef SERIAL_H_
+#define SERIAL_H_
+
+#include <stdint.h>
+#include <termios.h>
+
+speed_t serialBaud(uint32_t baud);
+int serialRaw(int fd, uint32_t baud, uint8_t timeout);
+int serialOpen(const char *path, uint32_t baud, uint8_t timeout);
+
+#endif /* SERIAL_H_ */